@@ -123,15 +123,11 @@ void main()
                shadow = ShadowCalculation(FragPosLightSpace, lightDirNorm, effectiveNormal);
             }
             else if (useRayTracing) {
-                vec2 texCoord;
-                vec4 projCoord = lightSpaceMatrix * vec4(FragPos, 1.0);
-                projCoord.xyz /= projCoord.w;
-                projCoord.xyz = projCoord.xyz * 0.5 + 0.5;
+                // The ray-traced mask is in screen space, first row at the top of the screen
+                vec2 texCoord = gl_FragCoord.xy / vec2(screenWidth, screenHeight);
+                float shadowValue = texture(shadowMap, vec2(texCoord.x, 1.0 - texCoord.y)).r;
     
-                float currentDepth = projCoord.z;
-                float shadowValue = texture(shadowMap, projCoord.xy).r;
-    
-                shadow = (shadowValue < 0.5) ? 1.0 : 0.0;
+                shadow = 1.0 - shadowValue; // soft values come from progressive accumulation
             }
         }
 
@@ -2,21 +2,25 @@
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aTexCoords;
+layout(location = 5) in mat4 aInstanceModel;
 
 out vec2 TexCoords;
 out vec3 Normal;
 out vec3 FragPos;
 out vec4 FragPosLightSpace;
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 uniform mat4 lightSpaceMatrix;
+uniform vec3 positionScale = vec3(1.0);
+uniform vec3 positionOffset = vec3(0.0);
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-    FragPos = vec3(model * vec4(aPos, 1.0));
+    mat4 model = aInstanceModel;
+    vec3 position = aPos * positionScale + positionOffset;
+    gl_Position = projection * view * model * vec4(position, 1.0);
+    FragPos = vec3(model * vec4(position, 1.0));
     Normal = mat3(transpose(inverse(model))) * aNormal;
     TexCoords = aTexCoords;
     FragPosLightSpace = lightSpaceMatrix * vec4(FragPos, 1.0);
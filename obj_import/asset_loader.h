@@ -0,0 +1,258 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include "model.h"
+#include "asset_registry.h"
+#include "job_system.h"
+#include "log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//     GPU  
+const float ASSET_UPLOAD_BUDGET_MS = 4.0f;
+
+enum AssetLoadState { ASSET_LOAD_IMPORTING, ASSET_LOAD_DECODING, ASSET_LOAD_UPLOADING, ASSET_LOAD_DONE, ASSET_LOAD_FAILED, ASSET_LOAD_CANCELLED };
+
+//    . ,  , BVH      ,
+//  GL- -      (AssetLoader::ProcessUploads)
+class AssetLoadJob {
+public:
+   explicit AssetLoadJob(const string& path) : path(path) {}
+   ~AssetLoadJob() {
+      for (DecodedImage& image : images) image.Free();
+   }
+
+   const string& Path() const { return path; }
+   AssetLoadState State() const { return static_cast<AssetLoadState>(state.load()); }
+   float Progress() const { return progress.load(); }
+   bool Finished() const { return State() >= ASSET_LOAD_DONE; }
+   void Cancel() { cancelRequested = true; }
+
+   const char* StateName() const {
+      switch (State()) {
+      case ASSET_LOAD_IMPORTING: return "Importing";
+      case ASSET_LOAD_DECODING: return "Decoding textures";
+      case ASSET_LOAD_UPLOADING: return "Uploading";
+      case ASSET_LOAD_DONE: return "Done";
+      case ASSET_LOAD_FAILED: return "Failed";
+      default: return "Cancelled";
+      }
+   }
+
+   //     ;     ASSET_LOAD_DONE
+   ModelHandle TakeModel() { return std::move(result); }
+
+private:
+   friend class AssetLoader;
+
+   string path;
+   string registryKey;
+   std::atomic<int> state{ ASSET_LOAD_IMPORTING };
+   std::atomic<float> progress{ 0.0f };
+   std::atomic<bool> cancelRequested{ false };
+
+   //       ASSET_LOAD_UPLOADING
+   vector<MeshData> meshData;
+   vector<DecodedImage> images;
+   vector<string> imageRefs; //   ,    ,  images
+   vector<TextureUsage> imageUsages;
+   vector<string> imageKeys;   //    
+   vector<TextureHandle> cachedImages; //     ;     
+   std::shared_ptr<const BVH> bvh;
+   AABB bounds;
+   BoundingSphere boundingSphere;
+
+   //    GPU,   
+   size_t nextImage = 0;
+   size_t nextMesh = 0;
+   Model model;
+   ModelHandle result;
+};
+
+//    
+class AssetLoader {
+public:
+   explicit AssetLoader(JobSystem& jobs) : jobs(jobs) {}
+
+   // format -    GPU, residency -        CPU.
+   // ,      ,   ,    
+   std::shared_ptr<AssetLoadJob> Load(const string& path, VertexFormat format = VERTEX_FORMAT_FLOAT,
+      GeometryResidency residency = GEOMETRY_RESIDENCY_POSITIONS) {
+      auto job = std::make_shared<AssetLoadJob>(path);
+      job->registryKey = ModelRegistry::CanonicalKey(path, format, residency);
+      if ((job->result = GlobalModelRegistry().Find(job->registryKey))) {
+         job->progress = 1.0f;
+         job->state = ASSET_LOAD_DONE;
+         return job;
+      }
+      job->model.vertexFormat = format;
+      job->model.geometryResidency = residency;
+      inFlight++;
+      jobs.Submit([this, job] {
+         //     ,  WaitIdle     
+         struct InFlightGuard {
+            std::atomic<int>& counter;
+            ~InFlightGuard() { counter--; }
+         } guard{ inFlight };
+         try {
+            Prepare(*job);
+         }
+         catch (const std::exception& e) {
+            LOG_ERROR("Asset load failed: %s: %s", job->path.c_str(), e.what());
+            job->state = ASSET_LOAD_FAILED;
+            return;
+         }
+         catch (...) {
+            LOG_ERROR("Asset load failed: %s: unknown exception", job->path.c_str());
+            job->state = ASSET_LOAD_FAILED;
+            return;
+         }
+         if (job->State() == ASSET_LOAD_UPLOADING) {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            uploadQueue.push_back(job);
+         }
+      });
+      return job;
+   }
+
+   //  GL-   ,    budgetMs (    ).
+   //  -     .       GL-
+   void ProcessUploads(float budgetMs = ASSET_UPLOAD_BUDGET_MS) {
+      auto start = std::chrono::high_resolution_clock::now();
+      std::lock_guard<std::mutex> lock(queueMutex);
+      while (!uploadQueue.empty()) {
+         AssetLoadJob& job = *uploadQueue.front();
+         if (job.cancelRequested) {
+            DiscardUploads(job);
+            job.state = ASSET_LOAD_CANCELLED;
+            uploadQueue.erase(uploadQueue.begin());
+            continue;
+         }
+
+         if (UploadStep(job)) {
+            LOG_INFO("Asset loaded: %s (%zu meshes, %zu textures)", job.path.c_str(), job.model.meshes.size(), job.model.textures_loaded.size());
+            job.result = GlobalModelRegistry().Insert(job.registryKey, std::move(job.model));
+            job.model = Model();
+            job.state = ASSET_LOAD_DONE;
+            uploadQueue.erase(uploadQueue.begin());
+         }
+         if (std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count() >= budgetMs)
+            break;
+      }
+   }
+
+   size_t Pending() const { return inFlight.load() + QueuedUploads(); }
+
+   //      :    
+   void WaitIdle() const {
+      while (inFlight.load() > 0) std::this_thread::yield();
+   }
+
+private:
+   JobSystem& jobs;
+   mutable std::mutex queueMutex;
+   vector<std::shared_ptr<AssetLoadJob>> uploadQueue;
+   std::atomic<int> inFlight{ 0 };
+
+   size_t QueuedUploads() const {
+      std::lock_guard<std::mutex> lock(queueMutex);
+      return uploadQueue.size();
+   }
+
+   //  :  ( ),  , BVH  .    
+   void Prepare(AssetLoadJob& job) {
+      auto cancelled = [&] {
+         if (!job.cancelRequested) return false;
+         job.state = ASSET_LOAD_CANCELLED;
+         return true;
+      };
+
+      if (!Model::LoadMeshData(job.path, job.meshData)) {
+         job.state = ASSET_LOAD_FAILED;
+         return;
+      }
+      job.progress = 0.4f;
+      if (cancelled()) return;
+
+      //   ; loadTexture     textureHandles
+      job.state = ASSET_LOAD_DECODING;
+      for (const MeshData& mesh : job.meshData)
+         for (const MeshTextureRef& ref : mesh.textures)
+            if (std::find(job.imageRefs.begin(), job.imageRefs.end(), ref.path) == job.imageRefs.end()) {
+               job.imageRefs.push_back(ref.path);
+               job.imageUsages.push_back(Model::TextureUsageOf(ref));
+            }
+
+      // ,     ,  
+      string directory = job.path.substr(0, job.path.find_last_of('/'));
+      job.images.resize(job.imageRefs.size());
+      job.imageKeys.resize(job.imageRefs.size());
+      job.cachedImages.resize(job.imageRefs.size());
+      std::atomic<uint32_t> decoded{ 0 };
+      jobs.ParallelFor(static_cast<uint32_t>(job.images.size()), [&](uint32_t i, unsigned) {
+         if (job.cancelRequested) return;
+         string file = directory + '/' + job.imageRefs[i];
+         job.imageKeys[i] = TextureCache::CanonicalKey(file, job.imageUsages[i]);
+         job.cachedImages[i] = GlobalTextureCache().Find(job.imageKeys[i]);
+         if (!job.cachedImages[i])
+            DecodeImage(file, job.images[i], job.imageUsages[i]);
+         job.progress = 0.4f + 0.3f * float(++decoded) / job.images.size();
+      });
+      if (cancelled()) return;
+
+      auto built = std::make_shared<BVH>();
+      built->Build(job.meshData);
+      job.bvh = built;
+      Model::ComputeBounds(job.meshData, job.bounds, job.boundingSphere);
+      job.progress = 0.7f;
+      if (cancelled()) return;
+
+      job.model.directory = directory;
+      job.state = ASSET_LOAD_UPLOADING;
+   }
+
+   //   .  true,    
+   bool UploadStep(AssetLoadJob& job) {
+      size_t totalSteps = job.images.size() + job.meshData.size();
+      if (job.nextImage < job.images.size()) {
+         //     ,      
+         DecodedImage& image = job.images[job.nextImage];
+         TextureHandle texture = job.cachedImages[job.nextImage];
+         if (!texture) texture = GlobalTextureCache().Insert(job.imageKeys[job.nextImage], image);
+         job.model.textureHandles.emplace(job.imageRefs[job.nextImage], texture);
+         image.Free();
+         job.nextImage++;
+      }
+      else if (job.nextMesh < job.meshData.size()) {
+         if (job.nextMesh == 0) job.model.meshes.reserve(job.meshData.size());
+         job.model.AppendMesh(std::move(job.meshData[job.nextMesh]));
+         job.nextMesh++;
+      }
+
+      size_t done = job.nextImage + job.nextMesh;
+      job.progress = 0.7f + 0.3f * (totalSteps ? float(done) / totalSteps : 1.0f);
+      if (done < totalSteps) return false;
+
+      job.model.FinishLoad(job.bvh, job.bounds, job.boundingSphere);
+      job.meshData.clear();
+      job.cachedImages.clear();
+      return true;
+   }
+
+   //    :  ,    .   ,      
+   void DiscardUploads(AssetLoadJob& job) {
+      for (Mesh& mesh : job.model.meshes)
+         mesh.ReleaseGL();
+      job.model = Model();
+      job.meshData.clear();
+   }
+};
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef ASSET_REGISTRY_H
+#define ASSET_REGISTRY_H
+
+#include "model.h"
+#include "texture_cache.h"
+
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//    .     ,   
+//   : ,       
+using ModelHandle = std::shared_ptr<const Model>;
+
+//            .     ,
+//     ,     GPU  .
+//  ,    ; GL-    CollectGarbage,
+//         
+class ModelRegistry {
+public:
+   struct Stats {
+      size_t models = 0;
+      size_t references = 0;    //    ,     
+      size_t geometryBytes = 0; // CPU-     
+      uint64_t hits = 0;
+      uint64_t misses = 0;
+   };
+
+   //      CPU    ,    
+   static std::string CanonicalKey(const std::string& path, VertexFormat format, GeometryResidency residency) {
+      return TextureCache::CanonicalKey(path) + "#" + std::to_string(static_cast<int>(format)) + std::to_string(static_cast<int>(residency));
+   }
+
+   //     nullptr.     
+   ModelHandle Find(const std::string& key) {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = entries.find(key);
+      if (it == entries.end()) return nullptr;
+      ModelHandle model = it->second.lock();
+      if (model) hits++;
+      return model;
+   }
+
+   //     .        ,
+   //   ,  GL-  .    GL-
+   ModelHandle Insert(const std::string& key, Model&& model) {
+      if (ModelHandle existing = Find(key)) {
+         model.ReleaseGL();
+         return existing;
+      }
+
+      ModelHandle handle = Adopt(std::move(model));
+      std::lock_guard<std::mutex> lock(mutex);
+      entries[key] = handle;
+      misses++;
+      return handle;
+   }
+
+   //   ,   ( ).    ,    
+   ModelHandle Adopt(Model&& model) {
+      return ModelHandle(new Model(std::move(model)), [this](Model* released) { Retire(released); });
+   }
+
+   //  ,     .        GL-
+   void CollectGarbage() {
+      std::vector<Model*> models;
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         models.swap(garbage);
+      }
+      for (Model* model : models) {
+         model->ReleaseGL();
+         delete model;
+      }
+   }
+
+   Stats GetStats() {
+      //    :     Retire
+      std::vector<ModelHandle> models;
+      Stats stats;
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         for (const auto& entry : entries)
+            if (ModelHandle model = entry.second.lock()) models.push_back(std::move(model));
+         stats.hits = hits;
+         stats.misses = misses;
+      }
+      stats.models = models.size();
+      for (const ModelHandle& model : models) {
+         stats.references += model.use_count() - 1;
+         stats.geometryBytes += model->GeometryBytes();
+      }
+      return stats;
+   }
+
+private:
+   std::mutex mutex;
+   std::unordered_map<std::string, std::weak_ptr<const Model>> entries;
+   std::vector<Model*> garbage;
+   uint64_t hits = 0;
+   uint64_t misses = 0;
+
+   void Retire(Model* model) {
+      std::lock_guard<std::mutex> lock(mutex);
+      //    ,      -  
+      for (auto it = entries.begin(); it != entries.end();)
+         it = it->second.expired() ? entries.erase(it) : std::next(it);
+      garbage.push_back(model);
+   }
+};
+
+//     :  SceneObject      
+inline ModelRegistry& GlobalModelRegistry() {
+   static ModelRegistry* registry = new ModelRegistry();
+   return *registry;
+}
+
+//    ,     
+inline const ModelHandle& EmptyModel() {
+   static ModelHandle* empty = new ModelHandle(std::make_shared<Model>());
+   return *empty;
+}
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <glm/glm.hpp>
+
+#include "geometry.h"
+#include "model.h"
+#include "obj_parser.h"
+#include "tangent_space.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+//     :   RayTriangleIntersect
+//  SoA- (, SSE, AVX2). : obj_import --bench-intersect
+inline int RunIntersectionBenchmark(int triangleCount = 4096, int rayCount = 4096)
+{
+   std::mt19937 rng(12345);
+   std::uniform_real_distribution<float> coord(-1.0f, 1.0f);
+
+   std::vector<glm::vec3> vertices;
+   vertices.reserve(triangleCount * 3);
+   for (int i = 0; i < triangleCount; ++i) {
+      glm::vec3 center(coord(rng), coord(rng), coord(rng));
+      for (int k = 0; k < 3; ++k)
+         vertices.push_back(center + glm::vec3(coord(rng), coord(rng), coord(rng)) * 0.1f);
+   }
+
+   std::vector<TriangleBlock> blocks;
+   PackTriangleBlocks(vertices.data(), triangleCount, blocks);
+
+   std::vector<Ray> rays;
+   rays.reserve(rayCount);
+   for (int i = 0; i < rayCount; ++i)
+      rays.push_back(Ray(glm::vec3(coord(rng), coord(rng), coord(rng)) * 3.0f, glm::vec3(coord(rng), coord(rng), coord(rng))));
+
+   double tests = static_cast<double>(triangleCount) * rayCount;
+   SimdLevel detected = DetectSimdLevel();
+   std::cout << "Ray/triangle benchmark: " << triangleCount << " triangles x " << rayCount << " rays, CPU: "
+      << SimdLevelName(detected) << std::endl;
+
+   //   -      
+   int hits = 0;
+   auto start = std::chrono::high_resolution_clock::now();
+   for (const Ray& ray : rays) {
+      float best = std::numeric_limits<float>::max();
+      bool hit = false;
+      for (int i = 0; i < triangleCount; ++i) {
+         Triangle triangle(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]);
+         float t;
+         if (RayTriangleIntersect(ray, triangle, t) && t < best) {
+            best = t;
+            hit = true;
+         }
+      }
+      hits += hit ? 1 : 0;
+   }
+   double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+   double baseline = tests / seconds;
+   std::cout << "  RayTriangleIntersect: " << baseline / 1e6 << " Mtests/s (" << hits << " hits)" << std::endl;
+
+   const SimdLevel levels[] = { SIMD_SCALAR, SIMD_SSE, SIMD_AVX2 };
+   for (SimdLevel level : levels) {
+      if (level > detected) break;
+      RayTriangleBlockFn kernel = GetRayTriangleBlockKernel(level);
+
+      hits = 0;
+      start = std::chrono::high_resolution_clock::now();
+      for (const Ray& ray : rays) {
+         float best = std::numeric_limits<float>::max();
+         hits += kernel(ray, blocks.data(), static_cast<uint32_t>(blocks.size()), 0.0f, best, false) ? 1 : 0;
+      }
+      seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+      std::cout << "  " << SimdLevelName(level) << " blocks: " << tests / seconds / 1e6 << " Mtests/s, x"
+         << (tests / seconds) / baseline << " (" << hits << " hits)" << std::endl;
+   }
+   return 0;
+}
+
+//   gridSize x gridSize   , UV   -   OBJ  
+inline bool WriteBenchmarkGridObj(const std::string& path, int gridSize)
+{
+   std::ofstream out(path);
+   if (!out) return false;
+   out << "# obj_import benchmark grid\n";
+   for (int y = 0; y <= gridSize; ++y)
+      for (int x = 0; x <= gridSize; ++x)
+         out << "v " << x * 0.01f << " " << std::sin(x * 0.05f) * std::cos(y * 0.05f) << " " << y * 0.01f << "\n";
+   for (int y = 0; y <= gridSize; ++y)
+      for (int x = 0; x <= gridSize; ++x)
+         out << "vt " << float(x) / gridSize << " " << float(y) / gridSize << "\n";
+   out << "vn 0 1 0\n";
+   for (int y = 0; y < gridSize; ++y) {
+      for (int x = 0; x < gridSize; ++x) {
+         int a = y * (gridSize + 1) + x + 1, b = a + 1, c = a + gridSize + 2, d = a + gridSize + 1;
+         out << "f " << a << "/" << a << "/1 " << b << "/" << b << "/1 " << c << "/" << c << "/1 " << d << "/" << d << "/1\n";
+      }
+   }
+   return static_cast<bool>(out);
+}
+
+//  OBJ: Assimp + processMeshes   .     1024x1024.
+// : obj_import --bench-obj [.obj]
+inline int RunObjImportBenchmark(std::string path = std::string(), int repeats = 3)
+{
+   if (path.empty()) {
+      std::error_code ec;
+      std::filesystem::create_directories("cache", ec);
+      path = "cache/bench_grid.obj";
+      if (!std::filesystem::exists(path) && !WriteBenchmarkGridObj(path, 1024)) {
+         std::cout << "ERROR::BENCHMARK::CANNOT_WRITE " << path << std::endl;
+         return 1;
+      }
+   }
+   std::error_code ec;
+   double megabytes = std::filesystem::file_size(path, ec) / (1024.0 * 1024.0);
+   if (ec) {
+      std::cout << "ERROR::BENCHMARK::FILE_NOT_FOUND " << path << std::endl;
+      return 1;
+   }
+   std::cout << "OBJ import benchmark: " << path << " (" << megabytes << " MB), best of " << repeats << ", "
+      << GlobalJobSystem().ThreadCount() << " threads" << std::endl;
+
+   auto run = [&](const char* name, const std::function<bool(std::vector<MeshData>&)>& load) {
+      double best = std::numeric_limits<double>::max();
+      size_t vertices = 0, triangles = 0;
+      for (int i = 0; i < repeats; ++i) {
+         std::vector<MeshData> meshes;
+         auto start = std::chrono::high_resolution_clock::now();
+         if (!load(meshes)) {
+            std::cout << "  " << name << ": failed" << std::endl;
+            return 0.0;
+         }
+         best = std::min(best, std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+         vertices = triangles = 0;
+         for (const MeshData& mesh : meshes) {
+            vertices += mesh.vertices.size();
+            triangles += mesh.indices.size() / 3;
+         }
+      }
+      std::cout << "  " << name << ": " << best * 1000.0 << " ms, " << megabytes / best << " MB/s ("
+         << vertices << " vertices, " << triangles << " triangles)" << std::endl;
+      return best;
+   };
+
+   double assimp = run("Assimp", [&](std::vector<MeshData>& meshes) { return Model::ImportMeshData(path, meshes, false); });
+   double native = run("Native", [&](std::vector<MeshData>& meshes) { return ParseObjFile(path, meshes); });
+   if (assimp > 0.0 && native > 0.0)
+      std::cout << "  speedup: x" << assimp / native << std::endl;
+
+   //      (tangent_space.h)   ,   
+   run("Native + normals/tangents", [&](std::vector<MeshData>& meshes) {
+      if (!ParseObjFile(path, meshes)) return false;
+      for (MeshData& mesh : meshes) {
+         GenerateSmoothNormals(mesh);
+         GenerateTangents(mesh);
+      }
+      return true;
+   });
+   return 0;
+}
+
+#endif
@@ -0,0 +1,428 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <glm/glm.hpp>
+
+#include "geometry.h"
+#include "mesh.h"
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+//    .      :
+//    (primCount == 0) leftFirst -   ,     ,
+//   leftFirst -      
+struct BVHNode {
+   glm::vec3 minBounds;
+   uint32_t leftFirst;
+   glm::vec3 maxBounds;
+   uint32_t primCount;
+
+   bool IsLeaf() const { return primCount > 0; }
+};
+
+const int BVH_SAH_BINS = 12;         //     
+const float BVH_TRAVERSAL_COST = 1.0f; //       
+const int BVH_STACK_SIZE = 64;
+//   ( - 0)   BVH_STACK_SIZE,     .
+//   BVH_MEDIAN_SPLIT_DEPTH      ,    SAH:
+//     2^24 
+const int BVH_MEDIAN_SPLIT_DEPTH = BVH_STACK_SIZE - 24;
+
+//  . leafGranularity -      
+// ( SIMD-   ),  SAH       
+struct BVHBuildSettings {
+   uint32_t maxLeafSize = 4;
+   uint32_t leafGranularity = 1;
+};
+
+//        (binned SAH).
+// primIndices     ,      
+inline void BuildBVHNodes(const std::vector<AABB>& primBounds, std::vector<BVHNode>& nodes, std::vector<uint32_t>& primIndices,
+   const BVHBuildSettings& settings = BVHBuildSettings())
+{
+   auto primCost = [&](uint32_t n) {
+      uint32_t g = settings.leafGranularity;
+      return static_cast<float>((n + g - 1) / g * g);
+   };
+
+   nodes.clear();
+   primIndices.resize(primBounds.size());
+   if (primBounds.empty()) return;
+
+   std::vector<glm::vec3> centroids(primBounds.size());
+   for (uint32_t i = 0; i < primBounds.size(); ++i) {
+      primIndices[i] = i;
+      centroids[i] = primBounds[i].Center();
+   }
+
+   nodes.reserve(primBounds.size() * 2);
+   nodes.push_back({ glm::vec3(0.0f), 0, glm::vec3(0.0f), static_cast<uint32_t>(primBounds.size()) });
+
+   auto updateBounds = [&](uint32_t nodeIdx) {
+      BVHNode& node = nodes[nodeIdx];
+      AABB box;
+      for (uint32_t i = 0; i < node.primCount; ++i)
+         box.Grow(primBounds[primIndices[node.leftFirst + i]]);
+      node.minBounds = box.minBounds;
+      node.maxBounds = box.maxBounds;
+   };
+   updateBounds(0);
+
+   auto split = [&](uint32_t nodeIdx, uint32_t leftCount, int depth, std::vector<std::pair<uint32_t, int>>& stack) {
+      uint32_t first = nodes[nodeIdx].leftFirst;
+      uint32_t count = nodes[nodeIdx].primCount;
+      uint32_t leftIdx = static_cast<uint32_t>(nodes.size());
+      nodes.push_back({ glm::vec3(0.0f), first, glm::vec3(0.0f), leftCount });
+      nodes.push_back({ glm::vec3(0.0f), first + leftCount, glm::vec3(0.0f), count - leftCount });
+      nodes[nodeIdx].leftFirst = leftIdx;
+      nodes[nodeIdx].primCount = 0;
+      updateBounds(leftIdx);
+      updateBounds(leftIdx + 1);
+      stack.push_back({ leftIdx, depth + 1 });
+      stack.push_back({ leftIdx + 1, depth + 1 });
+   };
+
+   std::vector<std::pair<uint32_t, int>> stack = { { 0, 0 } };
+   while (!stack.empty()) {
+      uint32_t nodeIdx = stack.back().first;
+      int depth = stack.back().second;
+      stack.pop_back();
+
+      uint32_t first = nodes[nodeIdx].leftFirst;
+      uint32_t count = nodes[nodeIdx].primCount;
+      if (count <= 2 || depth >= BVH_STACK_SIZE) continue;
+
+      AABB centroidBox;
+      for (uint32_t i = 0; i < count; ++i)
+         centroidBox.Grow(centroids[primIndices[first + i]]);
+
+      //    (SAH       ):     
+      if (depth >= BVH_MEDIAN_SPLIT_DEPTH) {
+         glm::vec3 extent = centroidBox.maxBounds - centroidBox.minBounds;
+         int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+         auto begin = primIndices.begin() + first;
+         std::nth_element(begin, begin + count / 2, begin + count, [&](uint32_t a, uint32_t b) {
+            return centroids[a][axis] < centroids[b][axis];
+         });
+         split(nodeIdx, count / 2, depth, stack);
+         continue;
+      }
+
+      //       
+      int bestAxis = -1;
+      int bestSplit = 0;
+      float bestCost = std::numeric_limits<float>::max();
+      for (int axis = 0; axis < 3; ++axis) {
+         float lo = centroidBox.minBounds[axis];
+         float hi = centroidBox.maxBounds[axis];
+         if (hi <= lo) continue;
+
+         AABB bins[BVH_SAH_BINS];
+         uint32_t binCount[BVH_SAH_BINS] = {};
+         float scale = BVH_SAH_BINS / (hi - lo);
+         for (uint32_t i = 0; i < count; ++i) {
+            uint32_t prim = primIndices[first + i];
+            int b = std::min(BVH_SAH_BINS - 1, static_cast<int>((centroids[prim][axis] - lo) * scale));
+            binCount[b]++;
+            bins[b].Grow(primBounds[prim]);
+         }
+
+         //         
+         float leftArea[BVH_SAH_BINS - 1], rightArea[BVH_SAH_BINS - 1];
+         uint32_t leftCount[BVH_SAH_BINS - 1], rightCount[BVH_SAH_BINS - 1];
+         AABB leftBox, rightBox;
+         uint32_t leftSum = 0, rightSum = 0;
+         for (int i = 0; i < BVH_SAH_BINS - 1; ++i) {
+            leftSum += binCount[i];
+            leftBox.Grow(bins[i]);
+            leftCount[i] = leftSum;
+            leftArea[i] = leftBox.HalfArea();
+
+            rightSum += binCount[BVH_SAH_BINS - 1 - i];
+            rightBox.Grow(bins[BVH_SAH_BINS - 1 - i]);
+            rightCount[BVH_SAH_BINS - 2 - i] = rightSum;
+            rightArea[BVH_SAH_BINS - 2 - i] = rightBox.HalfArea();
+         }
+         for (int i = 0; i < BVH_SAH_BINS - 1; ++i) {
+            if (leftCount[i] == 0 || rightCount[i] == 0) continue;
+            float cost = primCost(leftCount[i]) * leftArea[i] + primCost(rightCount[i]) * rightArea[i];
+            if (cost < bestCost) {
+               bestCost = cost;
+               bestAxis = axis;
+               bestSplit = i;
+            }
+         }
+      }
+
+      AABB nodeBox;
+      nodeBox.minBounds = nodes[nodeIdx].minBounds;
+      nodeBox.maxBounds = nodes[nodeIdx].maxBounds;
+      float leafCost = primCost(count) * nodeBox.HalfArea();
+      bestCost += BVH_TRAVERSAL_COST * nodeBox.HalfArea();
+      if (bestAxis < 0 || (count <= settings.maxLeafSize && bestCost >= leafCost)) continue;
+
+      //     
+      float lo = centroidBox.minBounds[bestAxis];
+      float scale = BVH_SAH_BINS / (centroidBox.maxBounds[bestAxis] - lo);
+      auto middle = std::partition(primIndices.begin() + first, primIndices.begin() + first + count, [&](uint32_t prim) {
+         int b = std::min(BVH_SAH_BINS - 1, static_cast<int>((centroids[prim][bestAxis] - lo) * scale));
+         return b <= bestSplit;
+      });
+      uint32_t leftCountFinal = static_cast<uint32_t>(middle - (primIndices.begin() + first));
+      if (leftCountFinal == 0 || leftCountFinal == count) continue;
+      split(nodeIdx, leftCountFinal, depth, stack);
+   }
+}
+
+//  . leafFn(first, count, tMax)   ,  tMax   true  .
+//  anyHit      
+template <typename LeafFn>
+inline bool TraverseBVH(const std::vector<BVHNode>& nodes, const Ray& ray, float tMin, float& tMax, bool anyHit, LeafFn&& leafFn)
+{
+   if (nodes.empty()) return false;
+
+   glm::vec3 invDir = 1.0f / ray.direction;
+   bool hit = false;
+   float tNear;
+   if (!RayAABBIntersect(ray.origin, invDir, nodes[0].minBounds, nodes[0].maxBounds, tMin, tMax, tNear))
+      return false;
+
+   uint32_t stack[BVH_STACK_SIZE];
+   int stackSize = 0;
+   uint32_t nodeIdx = 0;
+   while (true) {
+      const BVHNode& node = nodes[nodeIdx];
+      if (node.IsLeaf()) {
+         if (leafFn(node.leftFirst, node.primCount, tMax)) {
+            hit = true;
+            if (anyHit) return true;
+         }
+      }
+      else {
+         //     ,    
+         uint32_t left = node.leftFirst, right = node.leftFirst + 1;
+         float tLeft, tRight;
+         bool hitLeft = RayAABBIntersect(ray.origin, invDir, nodes[left].minBounds, nodes[left].maxBounds, tMin, tMax, tLeft);
+         bool hitRight = RayAABBIntersect(ray.origin, invDir, nodes[right].minBounds, nodes[right].maxBounds, tMin, tMax, tRight);
+         if (hitLeft && hitRight) {
+            if (tRight < tLeft) std::swap(left, right);
+            //      (BuildBVHNodes),  
+            assert(stackSize < BVH_STACK_SIZE);
+            stack[stackSize++] = right;
+            nodeIdx = left;
+            continue;
+         }
+         if (hitLeft) { nodeIdx = left; continue; }
+         if (hitRight) { nodeIdx = right; continue; }
+      }
+      if (stackSize == 0) break;
+      nodeIdx = stack[--stackSize];
+   }
+   return hit;
+}
+
+//         .     .
+//    SoA- (TriangleBlock): leftFirst  -   ,
+// primCount -    
+class BVH {
+public:
+   std::vector<BVHNode> nodes;
+   std::vector<TriangleBlock> blocks;
+   size_t triangleCount = 0;
+
+   //    ;      vertices/indices (Mesh  MeshData)
+   template <typename MeshList>
+   void Build(const MeshList& meshes) {
+      std::vector<glm::vec3> source;
+      for (const auto& mesh : meshes) {
+         for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+            source.push_back(mesh.vertices[mesh.indices[i]].Position);
+            source.push_back(mesh.vertices[mesh.indices[i + 1]].Position);
+            source.push_back(mesh.vertices[mesh.indices[i + 2]].Position);
+         }
+      }
+      BuildFromTriangles(source);
+   }
+
+   //     ( 3  )   
+   void BuildFromTriangles(const std::vector<glm::vec3>& source) {
+      size_t triCount = source.size() / 3;
+      std::vector<AABB> triBounds(triCount);
+      for (size_t i = 0; i < triCount; ++i) {
+         triBounds[i].Grow(source[i * 3]);
+         triBounds[i].Grow(source[i * 3 + 1]);
+         triBounds[i].Grow(source[i * 3 + 2]);
+      }
+
+      BVHBuildSettings settings;
+      settings.maxLeafSize = TRI_BLOCK_SIZE;
+      settings.leafGranularity = TRI_BLOCK_SIZE;
+      std::vector<uint32_t> order;
+      BuildBVHNodes(triBounds, nodes, order, settings);
+
+      //       
+      triangleCount = triCount;
+      blocks.clear();
+      std::vector<glm::vec3> leafVertices;
+      for (BVHNode& node : nodes) {
+         if (!node.IsLeaf()) continue;
+         leafVertices.clear();
+         for (uint32_t i = node.leftFirst; i < node.leftFirst + node.primCount; ++i) {
+            leafVertices.push_back(source[order[i] * 3]);
+            leafVertices.push_back(source[order[i] * 3 + 1]);
+            leafVertices.push_back(source[order[i] * 3 + 2]);
+         }
+         node.leftFirst = PackTriangleBlocks(leafVertices.data(), node.primCount, blocks);
+      }
+   }
+
+   size_t TriangleCount() const { return triangleCount; }
+
+   AABB Bounds() const {
+      AABB box;
+      if (!nodes.empty()) {
+         box.minBounds = nodes[0].minBounds;
+         box.maxBounds = nodes[0].maxBounds;
+      }
+      return box;
+   }
+
+   //     (tMin, tMax).   tMax    
+   bool Intersect(const Ray& ray, float tMin, float& tMax) const {
+      return TraverseBVH(nodes, ray, tMin, tMax, false, [&](uint32_t first, uint32_t count, float& tBest) {
+         return IntersectLeaf(ray, first, count, tMin, tBest, false);
+      });
+   }
+
+   //     (tMin, tMax) -   
+   bool Occluded(const Ray& ray, float tMin, float tMax) const {
+      return TraverseBVH(nodes, ray, tMin, tMax, true, [&](uint32_t first, uint32_t count, float& tBest) {
+         return IntersectLeaf(ray, first, count, tMin, tBest, true);
+      });
+   }
+
+private:
+   bool IntersectLeaf(const Ray& ray, uint32_t firstBlock, uint32_t triCount, float tMin, float& tMax, bool anyHit) const {
+      uint32_t blockCount = (triCount + TRI_BLOCK_SIZE - 1) / TRI_BLOCK_SIZE;
+      return GetRayTriangleBlockKernel()(ray, &blocks[firstBlock], blockCount, tMin, tMax, anyHit);
+   }
+};
+
+//    :   BVH      <-> .
+// BVH   ,   SceneBVH     
+struct BVHInstance {
+   std::shared_ptr<const BVH> blas;
+   glm::mat4 toWorld = glm::mat4(1.0f);
+   glm::mat4 toLocal = glm::mat4(1.0f);
+   AABB worldBounds;
+   BoundingSphere worldSphere;
+   int objectIndex = -1;
+};
+
+//  :      ,
+//        BVH  
+class SceneBVH {
+public:
+   std::vector<BVHInstance> instances;
+   std::vector<BVHNode> nodes;
+   std::vector<uint32_t> instanceOrder;
+
+   //  ,    : BVH     
+   struct SourceKey {
+      const BVH* blas;
+      unsigned long long transformVersion;
+      bool operator==(const SourceKey& other) const { return blas == other.blas && transformVersion == other.transformVersion; }
+   };
+   std::vector<SourceKey> sourceKeys;
+
+   void Clear() {
+      instances.clear();
+      nodes.clear();
+      instanceOrder.clear();
+      sourceKeys.clear();
+   }
+
+   // toLocal      ,       .
+   //       AABB
+   void AddInstance(const std::shared_ptr<const BVH>& blas, const glm::mat4& toWorld, const glm::mat4& toLocal, int objectIndex,
+                    const BoundingSphere& worldSphere = BoundingSphere()) {
+      if (!blas || blas->nodes.empty()) return;
+      BVHInstance inst;
+      inst.blas = blas;
+      inst.toWorld = toWorld;
+      inst.toLocal = toLocal;
+      inst.worldBounds = blas->Bounds().Transformed(toWorld);
+      inst.worldSphere = worldSphere;
+      if (!inst.worldSphere.Valid()) {
+         inst.worldSphere.center = inst.worldBounds.Center();
+         inst.worldSphere.radius = glm::length(inst.worldBounds.maxBounds - inst.worldBounds.minBounds) * 0.5f;
+      }
+      inst.objectIndex = objectIndex;
+      instances.push_back(inst);
+   }
+
+   AABB Bounds() const {
+      AABB box;
+      if (!nodes.empty()) {
+         box.minBounds = nodes[0].minBounds;
+         box.maxBounds = nodes[0].maxBounds;
+      }
+      return box;
+   }
+
+   void Build() {
+      std::vector<AABB> bounds(instances.size());
+      for (size_t i = 0; i < instances.size(); ++i)
+         bounds[i] = instances[i].worldBounds;
+      BuildBVHNodes(bounds, nodes, instanceOrder);
+   }
+
+   //    ; objectIndex -  ,    
+   bool Intersect(const Ray& ray, float tMin, float& tMax, int& objectIndex) const {
+      return TraverseBVH(nodes, ray, tMin, tMax, false, [&](uint32_t first, uint32_t count, float& tBest) {
+         bool hit = false;
+         for (uint32_t i = first; i < first + count; ++i) {
+            const BVHInstance& inst = instances[instanceOrder[i]];
+            if (!RaySphereOverlap(ray, inst.worldSphere, tMin, tBest)) continue;
+            if (inst.blas->Intersect(ToLocal(ray, inst), tMin, tBest)) {
+               objectIndex = inst.objectIndex;
+               hit = true;
+            }
+         }
+         return hit;
+      });
+   }
+
+   //        (tMin, tMax).  ignoreObject .
+   //         :   ,
+   //           AABB  
+   bool Occluded(const Ray& ray, float tMin, float tMax, int ignoreObject = -1) const {
+      return TraverseBVH(nodes, ray, tMin, tMax, true, [&](uint32_t first, uint32_t count, float& tBest) {
+         for (uint32_t i = first; i < first + count; ++i) {
+            const BVHInstance& inst = instances[instanceOrder[i]];
+            if (inst.objectIndex == ignoreObject) continue;
+            if (!RaySphereOverlap(ray, inst.worldSphere, tMin, tBest)) continue;
+            if (inst.blas->Occluded(ToLocal(ray, inst), tMin, tBest)) return true;
+         }
+         return false;
+      });
+   }
+
+private:
+   //   ,   t      .
+   //       ,    
+   static Ray ToLocal(const Ray& ray, const BVHInstance& inst) {
+      Ray local = ray;
+      const glm::mat4& m = inst.toLocal;
+      local.origin = glm::vec3(m[3]) + glm::mat3(m) * ray.origin;
+      local.direction = glm::mat3(m) * ray.direction;
+      return local;
+   }
+};
+
+#endif
@@ -1,10 +1,12 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
+layout (location = 5) in mat4 aInstanceModel;
 
 uniform mat4 lightSpaceMatrix;
-uniform mat4 model;
+uniform vec3 positionScale = vec3(1.0);
+uniform vec3 positionOffset = vec3(0.0);
 
 void main()
 {
-    gl_Position = lightSpaceMatrix * model * vec4(aPos, 1.0);
+    gl_Position = lightSpaceMatrix * aInstanceModel * vec4(aPos * positionScale + positionOffset, 1.0);
 }
\ No newline at end of file
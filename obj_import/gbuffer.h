@@ -0,0 +1,135 @@
+#ifndef GBUFFER_H
+#define GBUFFER_H
+
+#include <glad.h>
+
+#include <glm/glm.hpp>
+
+#include "bvh.h"
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+//    G-, ,     ,     .
+// : x -      , y -   + 1 (0 - ).   .
+//     scene:       ,   
+struct GBufferFrame {
+   glm::mat4 invProjection = glm::mat4(1.0f);
+   glm::mat4 invView = glm::mat4(1.0f);
+   glm::vec3 cameraPos = glm::vec3(0.0f);
+   SceneBVH scene;
+   std::shared_ptr<const std::vector<glm::vec2>> samples;
+};
+
+//       :   ,    
+// ,     CPU   .    PBO    
+class GBuffer {
+public:
+   GBuffer(unsigned int width, unsigned int height) : width(width), height(height) {
+      glGenFramebuffers(1, &fbo);
+      glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+      glGenTextures(1, &texture);
+      glBindTexture(GL_TEXTURE_2D, texture);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, width, height, 0, GL_RG, GL_FLOAT, NULL);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+
+      glGenRenderbuffers(1, &depthRBO);
+      glBindRenderbuffer(GL_RENDERBUFFER, depthRBO);
+      glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+      glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRBO);
+
+      if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+         std::cout << "ERROR::GBUFFER::FRAMEBUFFER_NOT_COMPLETE" << std::endl;
+      glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+      glGenBuffers(1, &pbo);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+      glBufferData(GL_PIXEL_PACK_BUFFER, PixelCount() * sizeof(glm::vec2), nullptr, GL_STREAM_READ);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+   }
+
+   //        
+   void Bind() const {
+      glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+      glViewport(0, 0, width, height);
+      glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+   }
+
+   //      PBO   GPU.    Fetch.
+   // scene - ,     ,    
+   void Capture(const glm::mat4& invProjection, const glm::mat4& invView, const glm::vec3& cameraPos, const SceneBVH& scene) {
+      if (pending) return;
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+      glReadBuffer(GL_COLOR_ATTACHMENT0);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+      glReadPixels(0, 0, width, height, GL_RG, GL_FLOAT, nullptr);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+      fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+      captured.invProjection = invProjection;
+      captured.invView = invView;
+      captured.cameraPos = cameraPos;
+      captured.scene = scene;
+      pending = true;
+   }
+
+   //   
+   bool Pending() const { return pending; }
+
+   //  ,  GPU   .  
+   bool Fetch(GBufferFrame& frame) {
+      if (!pending) return false;
+      GLenum status = glClientWaitSync(fence, 0, 0);
+      if (status == GL_TIMEOUT_EXPIRED) return false;
+      glDeleteSync(fence);
+      fence = nullptr;
+      pending = false;
+      if (status == GL_WAIT_FAILED) return false;
+
+      auto samples = std::make_shared<std::vector<glm::vec2>>(PixelCount());
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+      void* src = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, samples->size() * sizeof(glm::vec2), GL_MAP_READ_BIT);
+      bool mapped = src != nullptr;
+      if (mapped) {
+         std::memcpy(samples->data(), src, samples->size() * sizeof(glm::vec2));
+         glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+      }
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+      if (!mapped) return false;
+
+      frame = std::move(captured);
+      captured = GBufferFrame();
+      frame.samples = std::move(samples);
+      return true;
+   }
+
+   void Release() {
+      if (fence) glDeleteSync(fence);
+      fence = nullptr;
+      pending = false;
+      captured = GBufferFrame();
+      glDeleteFramebuffers(1, &fbo);
+      glDeleteTextures(1, &texture);
+      glDeleteRenderbuffers(1, &depthRBO);
+      glDeleteBuffers(1, &pbo);
+      fbo = texture = depthRBO = pbo = 0;
+   }
+
+private:
+   unsigned int width, height;
+   GLuint fbo = 0, texture = 0, depthRBO = 0, pbo = 0;
+   GLsync fence = nullptr;
+   bool pending = false;
+   GBufferFrame captured;
+
+   size_t PixelCount() const { return static_cast<size_t>(width) * height; }
+};
+
+#endif
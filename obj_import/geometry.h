@@ -1,6 +1,22 @@
 #pragma once
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <vector>
 
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define GEOMETRY_X86_SIMD 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define GEOMETRY_TARGET_AVX2
+#else
+#define GEOMETRY_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
 struct Ray {
    glm::vec3 origin;
    glm::vec3 direction;
@@ -45,6 +61,243 @@ bool RayTriangleIntersect(const Ray& ray, const Triangle& triangle, float& t) {
    return (t > EPSILON);
 }
 
+//     :   TRI_BLOCK_SIZE ,   
+//  v0   edge1/edge2.         
+const int TRI_BLOCK_SIZE = 8;
+const float RAY_TRIANGLE_EPSILON = 0.0000001f;
+
+struct alignas(32) TriangleBlock {
+   float v0x[TRI_BLOCK_SIZE], v0y[TRI_BLOCK_SIZE], v0z[TRI_BLOCK_SIZE];
+   float e1x[TRI_BLOCK_SIZE], e1y[TRI_BLOCK_SIZE], e1z[TRI_BLOCK_SIZE];
+   float e2x[TRI_BLOCK_SIZE], e2y[TRI_BLOCK_SIZE], e2z[TRI_BLOCK_SIZE];
+};
+
+//   ( 3  )  .     
+inline uint32_t PackTriangleBlocks(const glm::vec3* vertices, uint32_t triCount, std::vector<TriangleBlock>& blocks)
+{
+   uint32_t firstBlock = static_cast<uint32_t>(blocks.size());
+   for (uint32_t base = 0; base < triCount; base += TRI_BLOCK_SIZE) {
+      TriangleBlock block = {};
+      for (uint32_t lane = 0; lane < TRI_BLOCK_SIZE && base + lane < triCount; ++lane) {
+         const glm::vec3* tri = vertices + (base + lane) * 3;
+         glm::vec3 e1 = tri[1] - tri[0];
+         glm::vec3 e2 = tri[2] - tri[0];
+         block.v0x[lane] = tri[0].x; block.v0y[lane] = tri[0].y; block.v0z[lane] = tri[0].z;
+         block.e1x[lane] = e1.x; block.e1y[lane] = e1.y; block.e1z[lane] = e1.z;
+         block.e2x[lane] = e2.x; block.e2y[lane] = e2.y; block.e2z[lane] = e2.z;
+      }
+      blocks.push_back(block);
+   }
+   return firstBlock;
+}
+
+//       .    (tMin, tMax)  tMax   true
+typedef bool (*RayTriangleBlockFn)(const Ray& ray, const TriangleBlock* blocks, uint32_t blockCount, float tMin, float& tMax, bool anyHit);
+
+//   -   MollerTrumbore,   RayTriangleIntersect,     
+inline bool RayTriangleBlocksScalar(const Ray& ray, const TriangleBlock* blocks, uint32_t blockCount, float tMin, float& tMax, bool anyHit)
+{
+   bool hit = false;
+   tMin = std::max(tMin, RAY_TRIANGLE_EPSILON);
+   for (uint32_t b = 0; b < blockCount; ++b) {
+      const TriangleBlock& blk = blocks[b];
+      for (int i = 0; i < TRI_BLOCK_SIZE; ++i) {
+         glm::vec3 edge1(blk.e1x[i], blk.e1y[i], blk.e1z[i]);
+         glm::vec3 edge2(blk.e2x[i], blk.e2y[i], blk.e2z[i]);
+         glm::vec3 h = glm::cross(ray.direction, edge2);
+         float a = glm::dot(edge1, h);
+         if (a > -RAY_TRIANGLE_EPSILON && a < RAY_TRIANGLE_EPSILON)
+            continue;
+
+         float f = 1.0f / a;
+         glm::vec3 s = ray.origin - glm::vec3(blk.v0x[i], blk.v0y[i], blk.v0z[i]);
+         float u = f * glm::dot(s, h);
+         if (u < 0.0f || u > 1.0f)
+            continue;
+
+         glm::vec3 q = glm::cross(s, edge1);
+         float v = f * glm::dot(ray.direction, q);
+         if (v < 0.0f || u + v > 1.0f)
+            continue;
+
+         float t = f * glm::dot(edge2, q);
+         if (t > tMin && t < tMax) {
+            tMax = t;
+            hit = true;
+            if (anyHit) return true;
+         }
+      }
+   }
+   return hit;
+}
+
+#if defined(GEOMETRY_X86_SIMD)
+// SSE:      4 
+inline bool RayTriangleBlocksSSE(const Ray& ray, const TriangleBlock* blocks, uint32_t blockCount, float tMin, float& tMax, bool anyHit)
+{
+   const __m128 ox = _mm_set1_ps(ray.origin.x), oy = _mm_set1_ps(ray.origin.y), oz = _mm_set1_ps(ray.origin.z);
+   const __m128 dx = _mm_set1_ps(ray.direction.x), dy = _mm_set1_ps(ray.direction.y), dz = _mm_set1_ps(ray.direction.z);
+   const __m128 eps = _mm_set1_ps(RAY_TRIANGLE_EPSILON), negEps = _mm_set1_ps(-RAY_TRIANGLE_EPSILON);
+   const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+   const __m128 inf = _mm_set1_ps(std::numeric_limits<float>::infinity());
+   const __m128 tMinV = _mm_set1_ps(std::max(tMin, RAY_TRIANGLE_EPSILON));
+   __m128 tMaxV = _mm_set1_ps(tMax);
+   bool hit = false;
+
+   for (uint32_t b = 0; b < blockCount; ++b) {
+      const TriangleBlock& blk = blocks[b];
+      for (int half = 0; half < TRI_BLOCK_SIZE; half += 4) {
+         __m128 e1x = _mm_loadu_ps(blk.e1x + half), e1y = _mm_loadu_ps(blk.e1y + half), e1z = _mm_loadu_ps(blk.e1z + half);
+         __m128 e2x = _mm_loadu_ps(blk.e2x + half), e2y = _mm_loadu_ps(blk.e2y + half), e2z = _mm_loadu_ps(blk.e2z + half);
+
+         __m128 hx = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+         __m128 hy = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+         __m128 hz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+         __m128 a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, hx), _mm_mul_ps(e1y, hy)), _mm_mul_ps(e1z, hz));
+         __m128 mask = _mm_or_ps(_mm_cmpgt_ps(a, eps), _mm_cmplt_ps(a, negEps));
+         if (_mm_movemask_ps(mask) == 0) continue;
+
+         __m128 f = _mm_div_ps(one, a);
+         __m128 sx = _mm_sub_ps(ox, _mm_loadu_ps(blk.v0x + half));
+         __m128 sy = _mm_sub_ps(oy, _mm_loadu_ps(blk.v0y + half));
+         __m128 sz = _mm_sub_ps(oz, _mm_loadu_ps(blk.v0z + half));
+         __m128 u = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, hx), _mm_mul_ps(sy, hy)), _mm_mul_ps(sz, hz)));
+
+         __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+         __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+         __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+         __m128 v = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)));
+         __m128 t = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)));
+
+         mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmple_ps(u, one)));
+         mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmple_ps(_mm_add_ps(u, v), one)));
+         mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpgt_ps(t, tMinV), _mm_cmplt_ps(t, tMaxV)));
+         if (_mm_movemask_ps(mask) == 0) continue;
+
+         //   t   
+         __m128 tm = _mm_or_ps(_mm_and_ps(mask, t), _mm_andnot_ps(mask, inf));
+         tm = _mm_min_ps(tm, _mm_shuffle_ps(tm, tm, _MM_SHUFFLE(2, 3, 0, 1)));
+         tm = _mm_min_ps(tm, _mm_shuffle_ps(tm, tm, _MM_SHUFFLE(1, 0, 3, 2)));
+         tMax = _mm_cvtss_f32(tm);
+         tMaxV = _mm_set1_ps(tMax);
+         hit = true;
+         if (anyHit) return true;
+      }
+   }
+   return hit;
+}
+
+// AVX2 + FMA:    8    
+GEOMETRY_TARGET_AVX2
+inline bool RayTriangleBlocksAVX2(const Ray& ray, const TriangleBlock* blocks, uint32_t blockCount, float tMin, float& tMax, bool anyHit)
+{
+   const __m256 ox = _mm256_set1_ps(ray.origin.x), oy = _mm256_set1_ps(ray.origin.y), oz = _mm256_set1_ps(ray.origin.z);
+   const __m256 dx = _mm256_set1_ps(ray.direction.x), dy = _mm256_set1_ps(ray.direction.y), dz = _mm256_set1_ps(ray.direction.z);
+   const __m256 eps = _mm256_set1_ps(RAY_TRIANGLE_EPSILON), negEps = _mm256_set1_ps(-RAY_TRIANGLE_EPSILON);
+   const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+   const __m256 inf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+   const __m256 tMinV = _mm256_set1_ps(std::max(tMin, RAY_TRIANGLE_EPSILON));
+   __m256 tMaxV = _mm256_set1_ps(tMax);
+   bool hit = false;
+
+   for (uint32_t b = 0; b < blockCount; ++b) {
+      const TriangleBlock& blk = blocks[b];
+      __m256 e1x = _mm256_loadu_ps(blk.e1x), e1y = _mm256_loadu_ps(blk.e1y), e1z = _mm256_loadu_ps(blk.e1z);
+      __m256 e2x = _mm256_loadu_ps(blk.e2x), e2y = _mm256_loadu_ps(blk.e2y), e2z = _mm256_loadu_ps(blk.e2z);
+
+      __m256 hx = _mm256_fmsub_ps(dy, e2z, _mm256_mul_ps(dz, e2y));
+      __m256 hy = _mm256_fmsub_ps(dz, e2x, _mm256_mul_ps(dx, e2z));
+      __m256 hz = _mm256_fmsub_ps(dx, e2y, _mm256_mul_ps(dy, e2x));
+      __m256 a = _mm256_fmadd_ps(e1x, hx, _mm256_fmadd_ps(e1y, hy, _mm256_mul_ps(e1z, hz)));
+      __m256 mask = _mm256_or_ps(_mm256_cmp_ps(a, eps, _CMP_GT_OQ), _mm256_cmp_ps(a, negEps, _CMP_LT_OQ));
+      if (_mm256_movemask_ps(mask) == 0) continue;
+
+      __m256 f = _mm256_div_ps(one, a);
+      __m256 sx = _mm256_sub_ps(ox, _mm256_loadu_ps(blk.v0x));
+      __m256 sy = _mm256_sub_ps(oy, _mm256_loadu_ps(blk.v0y));
+      __m256 sz = _mm256_sub_ps(oz, _mm256_loadu_ps(blk.v0z));
+      __m256 u = _mm256_mul_ps(f, _mm256_fmadd_ps(sx, hx, _mm256_fmadd_ps(sy, hy, _mm256_mul_ps(sz, hz))));
+
+      __m256 qx = _mm256_fmsub_ps(sy, e1z, _mm256_mul_ps(sz, e1y));
+      __m256 qy = _mm256_fmsub_ps(sz, e1x, _mm256_mul_ps(sx, e1z));
+      __m256 qz = _mm256_fmsub_ps(sx, e1y, _mm256_mul_ps(sy, e1x));
+      __m256 v = _mm256_mul_ps(f, _mm256_fmadd_ps(dx, qx, _mm256_fmadd_ps(dy, qy, _mm256_mul_ps(dz, qz))));
+      __m256 t = _mm256_mul_ps(f, _mm256_fmadd_ps(e2x, qx, _mm256_fmadd_ps(e2y, qy, _mm256_mul_ps(e2z, qz))));
+
+      mask = _mm256_and_ps(mask, _mm256_and_ps(_mm256_cmp_ps(u, zero, _CMP_GE_OQ), _mm256_cmp_ps(u, one, _CMP_LE_OQ)));
+      mask = _mm256_and_ps(mask, _mm256_and_ps(_mm256_cmp_ps(v, zero, _CMP_GE_OQ), _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ)));
+      mask = _mm256_and_ps(mask, _mm256_and_ps(_mm256_cmp_ps(t, tMinV, _CMP_GT_OQ), _mm256_cmp_ps(t, tMaxV, _CMP_LT_OQ)));
+      if (_mm256_movemask_ps(mask) == 0) continue;
+
+      __m256 tm8 = _mm256_blendv_ps(inf, t, mask);
+      __m128 tm = _mm_min_ps(_mm256_castps256_ps128(tm8), _mm256_extractf128_ps(tm8, 1));
+      tm = _mm_min_ps(tm, _mm_shuffle_ps(tm, tm, _MM_SHUFFLE(2, 3, 0, 1)));
+      tm = _mm_min_ps(tm, _mm_shuffle_ps(tm, tm, _MM_SHUFFLE(1, 0, 3, 2)));
+      tMax = _mm_cvtss_f32(tm);
+      tMaxV = _mm256_set1_ps(tMax);
+      hit = true;
+      if (anyHit) return true;
+   }
+   return hit;
+}
+#endif
+
+enum SimdLevel { SIMD_SCALAR, SIMD_SSE, SIMD_AVX2 };
+
+//       
+inline SimdLevel DetectSimdLevel()
+{
+#if defined(GEOMETRY_X86_SIMD)
+#if defined(_MSC_VER)
+   int info[4];
+   __cpuid(info, 0);
+   int maxLeaf = info[0];
+   __cpuid(info, 1);
+   bool osxsave = (info[2] & (1 << 27)) != 0;
+   bool avx = (info[2] & (1 << 28)) != 0;
+   bool fma = (info[2] & (1 << 12)) != 0;
+   bool avx2 = false;
+   if (maxLeaf >= 7) {
+      __cpuidex(info, 7, 0);
+      avx2 = (info[1] & (1 << 5)) != 0;
+   }
+   bool osAvx = osxsave && ((_xgetbv(0) & 6) == 6); //   YMM-
+   return (avx && avx2 && fma && osAvx) ? SIMD_AVX2 : SIMD_SSE;
+#else
+   __builtin_cpu_init();
+   return (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) ? SIMD_AVX2 : SIMD_SSE;
+#endif
+#else
+   return SIMD_SCALAR;
+#endif
+}
+
+inline const char* SimdLevelName(SimdLevel level)
+{
+   switch (level) {
+   case SIMD_AVX2: return "AVX2";
+   case SIMD_SSE: return "SSE";
+   default: return "Scalar";
+   }
+}
+
+//    ;     ,   
+inline RayTriangleBlockFn GetRayTriangleBlockKernel(SimdLevel level)
+{
+#if defined(GEOMETRY_X86_SIMD)
+   if (level == SIMD_AVX2) return RayTriangleBlocksAVX2;
+   if (level == SIMD_SSE) return RayTriangleBlocksSSE;
+#endif
+   return RayTriangleBlocksScalar;
+}
+
+//     ,   
+inline RayTriangleBlockFn GetRayTriangleBlockKernel()
+{
+   static const RayTriangleBlockFn kernel = GetRayTriangleBlockKernel(DetectSimdLevel());
+   return kernel;
+}
+
 bool RaySphereIntersect(const Ray& ray, const glm::vec3& center, float radius, float& t) {
    glm::vec3 oc = ray.origin - center;
    float a = glm::dot(ray.direction, ray.direction);
@@ -58,6 +311,128 @@ bool RaySphereIntersect(const Ray& ray, const glm::vec3& center, float radius, f
    return t >= 0;
 }
 
+//  ,   
+struct AABB {
+   glm::vec3 minBounds = glm::vec3(std::numeric_limits<float>::max());
+   glm::vec3 maxBounds = glm::vec3(std::numeric_limits<float>::lowest());
+
+   void Grow(const glm::vec3& p) {
+      minBounds = glm::min(minBounds, p);
+      maxBounds = glm::max(maxBounds, p);
+   }
+
+   void Grow(const AABB& b) {
+      minBounds = glm::min(minBounds, b.minBounds);
+      maxBounds = glm::max(maxBounds, b.maxBounds);
+   }
+
+   bool Valid() const {
+      return minBounds.x <= maxBounds.x && minBounds.y <= maxBounds.y && minBounds.z <= maxBounds.z;
+   }
+
+   glm::vec3 Center() const { return (minBounds + maxBounds) * 0.5f; }
+
+   //    -    SAH
+   float HalfArea() const {
+      if (!Valid()) return 0.0f;
+      glm::vec3 e = maxBounds - minBounds;
+      return e.x * e.y + e.y * e.z + e.z * e.x;
+   }
+
+   // ,   8  
+   AABB Transformed(const glm::mat4& m) const {
+      AABB result;
+      if (!Valid()) return result;
+      for (int i = 0; i < 8; ++i) {
+         glm::vec3 corner((i & 1) ? maxBounds.x : minBounds.x,
+                          (i & 2) ? maxBounds.y : minBounds.y,
+                          (i & 4) ? maxBounds.z : minBounds.z);
+         result.Grow(glm::vec3(m * glm::vec4(corner, 1.0f)));
+      }
+      return result;
+   }
+};
+
+//  .    AABB     
+struct BoundingSphere {
+   glm::vec3 center = glm::vec3(0.0f);
+   float radius = -1.0f;
+
+   bool Valid() const { return radius >= 0.0f; }
+
+   //       ,    
+   BoundingSphere Transformed(const glm::mat4& m) const {
+      BoundingSphere result;
+      if (!Valid()) return result;
+      float scale = std::max(glm::length(glm::vec3(m[0])), std::max(glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2]))));
+      result.center = glm::vec3(m * glm::vec4(center, 1.0f));
+      result.radius = radius * scale;
+      return result;
+   }
+};
+
+enum FrustumTest { FRUSTUM_OUTSIDE, FRUSTUM_INTERSECTS, FRUSTUM_INSIDE };
+
+//  :   (xyz -  , w - ),   
+//  *  (* ).    ,      clip space
+struct Frustum {
+   glm::vec4 planes[6];
+
+   static Frustum FromMatrix(const glm::mat4& m) {
+      glm::vec4 row[4];
+      for (int i = 0; i < 4; ++i) row[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+      Frustum frustum;
+      for (int axis = 0; axis < 3; ++axis) {
+         frustum.planes[axis * 2] = row[3] + row[axis];     // -w <= x, y, z
+         frustum.planes[axis * 2 + 1] = row[3] - row[axis]; // x, y, z <= w
+      }
+      return frustum;
+   }
+
+   //       AABB:     (    -
+   //  AABB )    (   - AABB  ).  AABB 
+   FrustumTest Classify(const AABB& box) const {
+      if (!box.Valid()) return FRUSTUM_OUTSIDE;
+      FrustumTest result = FRUSTUM_INSIDE;
+      for (const glm::vec4& plane : planes) {
+         glm::vec3 normal(plane);
+         glm::vec3 farthest = glm::mix(box.minBounds, box.maxBounds, glm::greaterThan(normal, glm::vec3(0.0f)));
+         if (glm::dot(normal, farthest) + plane.w < 0.0f) return FRUSTUM_OUTSIDE;
+         glm::vec3 nearest = glm::mix(box.maxBounds, box.minBounds, glm::greaterThan(normal, glm::vec3(0.0f)));
+         if (glm::dot(normal, nearest) + plane.w < 0.0f) result = FRUSTUM_INTERSECTS;
+      }
+      return result;
+   }
+
+   bool Overlaps(const AABB& box) const {
+      return Classify(box) != FRUSTUM_OUTSIDE;
+   }
+};
+
+//       [tMin, tMax].     
+inline bool RaySphereOverlap(const Ray& ray, const BoundingSphere& sphere, float tMin, float tMax) {
+   glm::vec3 oc = sphere.center - ray.origin;
+   float tca = glm::dot(oc, ray.direction);
+   float d2 = glm::dot(oc, oc) - tca * tca;
+   float r2 = sphere.radius * sphere.radius;
+   if (d2 > r2) return false;
+   float thc = std::sqrt(r2 - d2);
+   return tca + thc >= tMin && tca - thc <= tMax;
+}
+
+//     AABB  . invDir -    
+inline bool RayAABBIntersect(const glm::vec3& origin, const glm::vec3& invDir, const glm::vec3& minBounds, const glm::vec3& maxBounds,
+   float tMin, float tMax, float& tNear)
+{
+   glm::vec3 t1 = (minBounds - origin) * invDir;
+   glm::vec3 t2 = (maxBounds - origin) * invDir;
+   glm::vec3 tSmall = glm::min(t1, t2);
+   glm::vec3 tBig = glm::max(t1, t2);
+   tNear = std::max(std::max(tSmall.x, tSmall.y), std::max(tSmall.z, tMin));
+   float tFar = std::min(std::min(tBig.x, tBig.y), std::min(tBig.z, tMax));
+   return tNear <= tFar;
+}
+
 //      ( ,  UV/)
 inline void GenerateSphere(float radius, unsigned int sectorCount, unsigned int stackCount,
    std::vector<float>& vertices, std::vector<unsigned int>& indices)
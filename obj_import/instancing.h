@@ -0,0 +1,158 @@
+#ifndef INSTANCING_H
+#define INSTANCING_H
+
+#include <glad.h>
+#include <glm/glm.hpp>
+
+#include "scene.h"
+#include "shader.h"
+
+#include <algorithm>
+#include <vector>
+
+//      (    )   
+// glDrawElementsInstanced  .        .
+//           
+class InstanceRenderer {
+public:
+   struct Stats {
+      size_t objects = 0;       //  
+      size_t culledObjects = 0; //    
+      size_t culledMeshes = 0;  //      
+      size_t batches = 0;
+      size_t drawCalls = 0;
+   };
+
+   InstanceRenderer() = default;
+   InstanceRenderer(const InstanceRenderer&) = delete;
+   InstanceRenderer& operator=(const InstanceRenderer&) = delete;
+
+   //  ,   include(index) ,  . prefix    
+   //   (  ).   ( ) .
+   // frustum      prefix (  *  * prefix), nullptr -  .
+   //      ,    -  
+   template <typename Filter>
+   void Build(const std::vector<SceneObject>& objects, const glm::mat4& prefix, const Frustum* frustum, Filter include) {
+      stats = Stats();
+      order.clear();
+      for (size_t i = 0; i < objects.size(); ++i) {
+         if (objects[i].model->meshes.empty() || !include(i)) continue;
+         FrustumTest test = frustum ? frustum->Classify(objects[i].GetWorldBounds()) : FRUSTUM_INSIDE;
+         if (test == FRUSTUM_OUTSIDE) {
+            stats.culledObjects++;
+            continue;
+         }
+         order.push_back({ static_cast<uint32_t>(i), test == FRUSTUM_INSIDE });
+      }
+      stats.objects = order.size();
+      //    ,  :        
+      std::stable_sort(order.begin(), order.end(), [&](const Entry& a, const Entry& b) {
+         const Model* ma = objects[a.index].model.get();
+         const Model* mb = objects[b.index].model.get();
+         return ma != mb ? ma < mb : a.inside > b.inside;
+      });
+
+      batches.clear();
+      meshDraws.clear();
+      matrices.clear();
+      for (size_t begin = 0; begin < order.size();) {
+         const Model* model = objects[order[begin].index].model.get();
+         size_t end = begin;
+         while (end < order.size() && objects[order[end].index].model.get() == model) ++end;
+
+         Batch batch = { model, static_cast<GLsizei>(matrices.size()), 0, static_cast<uint32_t>(meshDraws.size()), 0 };
+         size_t partial = begin;
+         for (; partial < end && order[partial].inside; ++partial) {
+            matrices.push_back(prefix * objects[order[partial].index].GetModelMatrix());
+            batch.count++;
+         }
+         //   :        ,   
+         partialMatrices.clear();
+         for (size_t k = partial; k < end; ++k)
+            partialMatrices.push_back(prefix * objects[order[k].index].GetModelMatrix());
+         for (uint32_t mesh = 0; partial < end && mesh < model->meshes.size(); ++mesh) {
+            MeshDraw draw = { mesh, static_cast<GLsizei>(matrices.size()), 0 };
+            for (size_t k = partial; k < end; ++k) {
+               if (!frustum->Overlaps(objects[order[k].index].GetWorldMeshBounds()[mesh])) {
+                  stats.culledMeshes++;
+                  continue;
+               }
+               matrices.push_back(partialMatrices[k - partial]);
+               draw.count++;
+            }
+            if (draw.count > 0) meshDraws.push_back(draw);
+         }
+         batch.meshDrawCount = static_cast<uint32_t>(meshDraws.size()) - batch.firstMeshDraw;
+         batches.push_back(batch);
+         begin = end;
+      }
+   }
+
+   //     ,      INSTANCE_MATRIX_ATTRIBUTE..+3.
+   //   Build  Draw   
+   void Draw(const Shader& shader, int reservedTextureUnit = -1) {
+      stats.batches = 0;
+      stats.drawCalls = 0;
+      if (matrices.empty()) return;
+
+      if (!buffer) glGenBuffers(1, &buffer);
+      glBindBuffer(GL_ARRAY_BUFFER, buffer);
+      //    ,   ,  GPU   
+      capacity = std::max(capacity, matrices.size());
+      glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+      glBufferSubData(GL_ARRAY_BUFFER, 0, matrices.size() * sizeof(glm::mat4), matrices.data());
+
+      for (const Batch& batch : batches) {
+         if (batch.count > 0) {
+            batch.model->DrawInstanced(shader, buffer, batch.first, batch.count, reservedTextureUnit);
+            stats.drawCalls += batch.model->meshes.size();
+         }
+         for (uint32_t i = batch.firstMeshDraw; i < batch.firstMeshDraw + batch.meshDrawCount; ++i) {
+            const MeshDraw& draw = meshDraws[i];
+            batch.model->meshes[draw.mesh].DrawInstanced(shader, batch.model->useOriginalTextures, buffer, draw.first, draw.count, reservedTextureUnit);
+            stats.drawCalls++;
+         }
+      }
+      stats.batches = batches.size();
+   }
+
+   const Stats& LastStats() const { return stats; }
+
+   void ReleaseGL() {
+      if (buffer) glDeleteBuffers(1, &buffer);
+      buffer = 0;
+      capacity = 0;
+   }
+
+private:
+   struct Entry {
+      uint32_t index;
+      bool inside; //    ,   
+   };
+
+   struct Batch {
+      const Model* model;
+      GLsizei first;  // ,  :      [first, first + count)
+      GLsizei count;
+      uint32_t firstMeshDraw;
+      uint32_t meshDrawCount;
+   };
+
+   //     
+   struct MeshDraw {
+      uint32_t mesh;
+      GLsizei first;
+      GLsizei count;
+   };
+
+   GLuint buffer = 0;
+   size_t capacity = 0;
+   std::vector<Entry> order;
+   std::vector<Batch> batches;
+   std::vector<MeshDraw> meshDraws;
+   std::vector<glm::mat4> matrices;
+   std::vector<glm::mat4> partialMatrices;
+   Stats stats;
+};
+
+#endif
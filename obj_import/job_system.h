@@ -0,0 +1,214 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include "log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//           .
+//       ,         
+class JobSystem {
+public:
+   explicit JobSystem(unsigned threadCount = 0) {
+      if (threadCount == 0)
+         threadCount = std::max(1u, std::thread::hardware_concurrency());
+      for (unsigned i = 0; i < threadCount; ++i)
+         queues.push_back(std::make_unique<WorkerQueue>());
+      for (unsigned i = 0; i < threadCount; ++i)
+         threads.emplace_back([this, i] { WorkerLoop(i); });
+   }
+
+   ~JobSystem() {
+      {
+         std::lock_guard<std::mutex> lock(sleepMutex);
+         stopping = true;
+      }
+      wakeUp.notify_all();
+      for (std::thread& t : threads)
+         t.join();
+   }
+
+   JobSystem(const JobSystem&) = delete;
+   JobSystem& operator=(const JobSystem&) = delete;
+
+   unsigned ThreadCount() const { return static_cast<unsigned>(threads.size()); }
+
+   //        -1,      
+   int CurrentWorker() const {
+      return CurrentOwnerSlot() == this ? CurrentWorkerSlot() : -1;
+   }
+
+   //     
+   void Submit(std::function<void()> task) {
+      int worker = CurrentWorker();
+      unsigned q = worker >= 0 ? static_cast<unsigned>(worker) : nextQueue++ % ThreadCount();
+      queues[q]->PushBack(std::move(task));
+      NotifyQueued(1);
+   }
+
+   //  fn(index, worker)  index  [0, count)     .
+   //      ,   .
+   //  fn  ,     ,   
+   //    
+   void ParallelFor(uint32_t count, const std::function<void(uint32_t index, unsigned worker)>& fn) {
+      if (count == 0) return;
+
+      struct Batch {
+         std::atomic<uint32_t> remaining;
+         std::mutex mutex;
+         std::condition_variable done;
+         std::exception_ptr error; //    fn,  mutex
+      };
+      auto batch = std::make_shared<Batch>();
+      batch->remaining = count;
+
+      unsigned n = ThreadCount();
+      uint32_t chunk = (count + n - 1) / n;
+      for (unsigned q = 0; q < n; ++q) {
+         uint32_t begin = q * chunk;
+         uint32_t end = std::min(count, begin + chunk);
+         //    :         
+         for (uint32_t i = end; i-- > begin;) {
+            queues[q]->PushBack([batch, &fn, i, this] {
+               try {
+                  fn(i, static_cast<unsigned>(std::max(0, CurrentWorker())));
+               }
+               catch (...) {
+                  std::lock_guard<std::mutex> lock(batch->mutex);
+                  if (!batch->error) batch->error = std::current_exception();
+               }
+               //     ,    
+               if (--batch->remaining == 0) {
+                  std::lock_guard<std::mutex> lock(batch->mutex);
+                  batch->done.notify_all();
+               }
+            });
+         }
+      }
+      NotifyQueued(count);
+
+      int worker = CurrentWorker();
+      if (worker >= 0) {
+         //     :  ,    
+         while (batch->remaining > 0) {
+            if (!RunOneTask(static_cast<unsigned>(worker)))
+               std::this_thread::yield();
+         }
+      }
+      else {
+         std::unique_lock<std::mutex> lock(batch->mutex);
+         batch->done.wait(lock, [&] { return batch->remaining == 0; });
+      }
+
+      std::exception_ptr error;
+      {
+         std::lock_guard<std::mutex> lock(batch->mutex);
+         error = batch->error;
+      }
+      if (error) std::rethrow_exception(error);
+   }
+
+private:
+   struct WorkerQueue {
+      std::mutex mutex;
+      std::deque<std::function<void()>> tasks;
+
+      void PushBack(std::function<void()> task) {
+         std::lock_guard<std::mutex> lock(mutex);
+         tasks.push_back(std::move(task));
+      }
+
+      bool PopBack(std::function<void()>& task) {
+         std::lock_guard<std::mutex> lock(mutex);
+         if (tasks.empty()) return false;
+         task = std::move(tasks.back());
+         tasks.pop_back();
+         return true;
+      }
+
+      bool StealFront(std::function<void()>& task) {
+         std::lock_guard<std::mutex> lock(mutex);
+         if (tasks.empty()) return false;
+         task = std::move(tasks.front());
+         tasks.pop_front();
+         return true;
+      }
+   };
+
+   std::vector<std::unique_ptr<WorkerQueue>> queues;
+   std::vector<std::thread> threads;
+   std::mutex sleepMutex;
+   std::condition_variable wakeUp;
+   std::atomic<int> queuedTasks{ 0 };
+   std::atomic<unsigned> nextQueue{ 0 };
+   bool stopping = false;
+
+   static int& CurrentWorkerSlot() {
+      thread_local int index = -1;
+      return index;
+   }
+
+   static const JobSystem*& CurrentOwnerSlot() {
+      thread_local const JobSystem* owner = nullptr;
+      return owner;
+   }
+
+   void NotifyQueued(int count) {
+      {
+         std::lock_guard<std::mutex> lock(sleepMutex);
+         queuedTasks += count;
+      }
+      if (count == 1) wakeUp.notify_one();
+      else wakeUp.notify_all();
+   }
+
+   bool RunOneTask(unsigned worker) {
+      std::function<void()> task;
+      bool found = queues[worker]->PopBack(task);
+      for (unsigned i = 1; !found && i < queues.size(); ++i)
+         found = queues[(worker + i) % queues.size()]->StealFront(task);
+      if (!found) return false;
+
+      queuedTasks--;
+      try {
+         task();
+      }
+      catch (const std::exception& e) {
+         LOG_ERROR("Job system: task failed: %s", e.what());
+      }
+      catch (...) {
+         LOG_ERROR("Job system: task failed with an unknown exception");
+      }
+      return true;
+   }
+
+   void WorkerLoop(unsigned worker) {
+      CurrentWorkerSlot() = static_cast<int>(worker);
+      CurrentOwnerSlot() = this;
+      while (true) {
+         if (RunOneTask(worker)) continue;
+
+         std::unique_lock<std::mutex> lock(sleepMutex);
+         wakeUp.wait(lock, [&] { return stopping || queuedTasks > 0; });
+         if (stopping && queuedTasks <= 0) return;
+      }
+   }
+};
+
+//     
+inline JobSystem& GlobalJobSystem() {
+   static JobSystem jobs;
+   return jobs;
+}
+
+#endif
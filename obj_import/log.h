@@ -0,0 +1,238 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//  .   LOG_MIN_LEVEL   
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO  2
+#define LOG_LEVEL_WARN  3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_OFF   5
+
+#ifndef LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define LOG_MIN_LEVEL LOG_LEVEL_INFO
+#else
+#define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LOG_PRINTF_FORMAT(fmt, args) __attribute__((format(printf, fmt, args)))
+#else
+#define LOG_PRINTF_FORMAT(fmt, args)
+#endif
+
+const size_t LOG_RING_SIZE = 256;    //   ,     
+const size_t LOG_MESSAGE_SIZE = 192; //  
+const int LOG_FLUSH_INTERVAL_MS = 50;
+
+//       .  -     
+//      ;      
+class Logger {
+public:
+   static Logger& Instance() {
+      static Logger logger;
+      return logger;
+   }
+
+   ~Logger() {
+      {
+         std::lock_guard<std::mutex> lock(flushMutex);
+         stopping = true;
+      }
+      wakeUp.notify_all();
+      if (flusher.joinable()) flusher.join();
+      Flush();
+   }
+
+   void Write(int level, const char* format, ...) LOG_PRINTF_FORMAT(3, 4) {
+      Ring& ring = ThreadRing();
+      uint32_t head = ring.head.load(std::memory_order_relaxed);
+      if (head - ring.tail.load(std::memory_order_acquire) >= LOG_RING_SIZE) {
+         ring.dropped.fetch_add(1, std::memory_order_relaxed);
+         return;
+      }
+
+      Entry& entry = ring.entries[head % LOG_RING_SIZE];
+      entry.level = level;
+      entry.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+      va_list args;
+      va_start(args, format);
+      std::vsnprintf(entry.text, LOG_MESSAGE_SIZE, format, args);
+      va_end(args);
+      ring.head.store(head + 1, std::memory_order_release);
+   }
+
+   //        
+   void Flush() {
+      std::lock_guard<std::mutex> lock(outputMutex);
+      {
+         std::lock_guard<std::mutex> ringLock(ringsMutex);
+         ringList.clear();
+         for (const auto& ring : rings)
+            ringList.push_back(ring.get());
+      }
+
+      pending.clear();
+      for (Ring* ringPtr : ringList) {
+         Ring& ring = *ringPtr;
+         uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+         uint32_t head = ring.head.load(std::memory_order_acquire);
+         for (; tail != head; ++tail)
+            pending.push_back({ ring.entries[tail % LOG_RING_SIZE], ring.index });
+         ring.tail.store(tail, std::memory_order_release);
+
+         uint32_t dropped = ring.dropped.exchange(0, std::memory_order_relaxed);
+         if (dropped > 0) {
+            PendingEntry note{ Entry(), ring.index };
+            note.entry.level = LOG_LEVEL_WARN;
+            note.entry.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            std::snprintf(note.entry.text, LOG_MESSAGE_SIZE, "%u log records dropped (ring buffer full)", dropped);
+            pending.push_back(note);
+         }
+      }
+
+      std::stable_sort(pending.begin(), pending.end(), [](const PendingEntry& a, const PendingEntry& b) {
+         return a.entry.time < b.entry.time;
+      });
+      for (const PendingEntry& p : pending) {
+         char prefix[48];
+         std::snprintf(prefix, sizeof(prefix), "[%9.3f] [%s] [T%u] ", p.entry.time, LevelName(p.entry.level), p.thread);
+         std::cout << prefix << p.entry.text << '\n';
+      }
+      if (!pending.empty()) std::cout.flush();
+   }
+
+   static const char* LevelName(int level) {
+      switch (level) {
+      case LOG_LEVEL_TRACE: return "TRACE";
+      case LOG_LEVEL_DEBUG: return "DEBUG";
+      case LOG_LEVEL_INFO: return "INFO ";
+      case LOG_LEVEL_WARN: return "WARN ";
+      case LOG_LEVEL_ERROR: return "ERROR";
+      default: return "?    ";
+      }
+   }
+
+private:
+   struct Entry {
+      int level = LOG_LEVEL_INFO;
+      double time = 0.0;
+      char text[LOG_MESSAGE_SIZE] = {};
+   };
+
+   //   ( )    (Flush)
+   struct Ring {
+      Entry entries[LOG_RING_SIZE];
+      std::atomic<uint32_t> head{ 0 };
+      std::atomic<uint32_t> tail{ 0 };
+      std::atomic<uint32_t> dropped{ 0 };
+      unsigned index = 0;
+   };
+
+   struct PendingEntry {
+      Entry entry;
+      unsigned thread;
+   };
+
+   std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+   std::vector<std::unique_ptr<Ring>> rings;
+   std::mutex ringsMutex;
+   std::mutex outputMutex;
+   std::vector<Ring*> ringList;
+   std::vector<PendingEntry> pending;
+
+   std::thread flusher;
+   std::mutex flushMutex;
+   std::condition_variable wakeUp;
+   bool stopping = false;
+
+   Logger() {
+      flusher = std::thread([this] { FlushLoop(); });
+   }
+
+   //            
+   Ring& ThreadRing() {
+      thread_local Ring* ring = nullptr;
+      if (!ring) {
+         auto created = std::make_unique<Ring>();
+         std::lock_guard<std::mutex> lock(ringsMutex);
+         created->index = static_cast<unsigned>(rings.size());
+         ring = created.get();
+         rings.push_back(std::move(created));
+      }
+      return *ring;
+   }
+
+   void FlushLoop() {
+      std::unique_lock<std::mutex> lock(flushMutex);
+      while (!stopping) {
+         wakeUp.wait_for(lock, std::chrono::milliseconds(LOG_FLUSH_INTERVAL_MS));
+         lock.unlock();
+         Flush();
+         lock.lock();
+      }
+   }
+};
+
+//       intervalMs . ,  
+class LogRateLimiter {
+public:
+   explicit LogRateLimiter(int intervalMs) : intervalNs(static_cast<int64_t>(intervalMs) * 1000000) {}
+
+   bool Allow() {
+      int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+      int64_t last = lastNs.load(std::memory_order_relaxed);
+      if (last != 0 && now - last < intervalNs) return false;
+      return lastNs.compare_exchange_strong(last, now, std::memory_order_relaxed);
+   }
+
+private:
+   int64_t intervalNs;
+   std::atomic<int64_t> lastNs{ 0 };
+};
+
+#define LOG_ENABLED(level) ((level) >= LOG_MIN_LEVEL)
+
+#define LOG_WRITE(level, ...) \
+   do { if (LOG_ENABLED(level)) Logger::Instance().Write(level, __VA_ARGS__); } while (0)
+
+#define LOG_TRACE(...) LOG_WRITE(LOG_LEVEL_TRACE, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_WRITE(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...)  LOG_WRITE(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...)  LOG_WRITE(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_WRITE(LOG_LEVEL_ERROR, __VA_ARGS__)
+
+//     intervalMs    
+#define LOG_RATE_LIMITED(level, intervalMs, ...) \
+   do { \
+      if (LOG_ENABLED(level)) { \
+         static LogRateLimiter logLimiter_(intervalMs); \
+         if (logLimiter_.Allow()) Logger::Instance().Write(level, __VA_ARGS__); \
+      } \
+   } while (0)
+
+//  n-      ( )
+#define LOG_EVERY_N(level, n, ...) \
+   do { \
+      if (LOG_ENABLED(level)) { \
+         static std::atomic<uint64_t> logCounter_{ 0 }; \
+         if (logCounter_.fetch_add(1, std::memory_order_relaxed) % (n) == 0) Logger::Instance().Write(level, __VA_ARGS__); \
+      } \
+   } while (0)
+
+#endif
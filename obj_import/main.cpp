@@ -16,7 +16,14 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <thread>
 #include "scene.h"
+#include "instancing.h"
+#include "benchmark.h"
+#include "shadow_tracer.h"
+#include "log.h"
+#include "profiler.h"
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -77,6 +84,26 @@ glm::vec3 ComputeSceneCenter() {
    return validObjects > 0 ? sum / static_cast<float>(validObjects) : glm::vec3(0.0f);
 }
 
+//         FIGURE_ROTATION  QUATERNION (   )
+glm::mat4 ComputeSceneRotation() {
+   glm::mat4 model = glm::mat4(1.0f);
+   if (cameraMode == FIGURE_ROTATION && editSceneMode && selectedObjectIndex == -1) {
+      glm::vec3 center = ComputeSceneCenter();
+      model = glm::translate(model, center);
+      model = glm::rotate(model, glm::radians(objectRotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+      model = glm::rotate(model, glm::radians(objectRotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+      model = glm::rotate(model, glm::radians(objectRotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+      model = glm::translate(model, -center);
+   }
+   else if (cameraMode == QUATERNION && editSceneMode && selectedObjectIndex == -1) {
+      glm::vec3 center = ComputeSceneCenter();
+      model = glm::translate(model, center);
+      model *= glm::mat4_cast(objectOrientation);
+      model = glm::translate(model, -center);
+   }
+   return model;
+}
+
 //    Ray Tracing 
 GLuint CreateRayTracingTexture(int width, int height) {
    GLuint textureID;
@@ -91,71 +118,22 @@ GLuint CreateRayTracingTexture(int width, int height) {
    return textureID;
 }
 
-bool TraceShadowRay(const glm::vec3& start, const glm::vec3& end, const std::vector<SceneObject>& objects, const SceneObject* ignoreObject) {
-   glm::vec3 direction = glm::normalize(end - start);
-   float lightDistance = glm::length(end - start);
-   Ray ray(start, direction);
-
-   //       
-   std::vector<std::pair<float, const SceneObject*>> sortedObjects;
-   for (const auto& obj : objects) {
-      if (&obj == ignoreObject) continue;
-      float dist = glm::length(obj.position - start);
-      sortedObjects.push_back({ dist, &obj });
+int main(int argc, char** argv)
+{
+   //     
+   if (argc > 1 && std::string(argv[1]) == "--bench-intersect") {
+      return RunIntersectionBenchmark();
    }
-   std::sort(sortedObjects.begin(), sortedObjects.end());
-
-   for (const auto& [dist, obj] : sortedObjects) {
-      //   -     
-      float maxScale = std::max({ obj->scale.x, obj->scale.y, obj->scale.z });
-      float radius = glm::length(obj->model.GetBoundingSphere()) * maxScale;
-
-      float sphereT;
-      if (RaySphereIntersect(ray, obj->position, radius, sphereT) &&
-         sphereT > 0.001f && sphereT < lightDistance) {
-         //      ...
-         glm::mat4 model = glm::mat4(1.0f);
-         model = glm::translate(model, obj->position);
-         model = glm::rotate(model, glm::radians(obj->rotation.x), glm::vec3(1, 0, 0));
-         model = glm::rotate(model, glm::radians(obj->rotation.y), glm::vec3(0, 1, 0));
-         model = glm::rotate(model, glm::radians(obj->rotation.z), glm::vec3(0, 0, 1));
-         model = glm::scale(model, obj->scale);
-
-         bool triangleHit = false;
-         for (const auto& mesh : obj->model.meshes) {
-            for (size_t i = 0; i < mesh.indices.size(); i += 3) {
-               glm::vec3 v0 = glm::vec3(model * glm::vec4(mesh.vertices[mesh.indices[i]].Position, 1.0f));
-               glm::vec3 v1 = glm::vec3(model * glm::vec4(mesh.vertices[mesh.indices[i + 1]].Position, 1.0f));
-               glm::vec3 v2 = glm::vec3(model * glm::vec4(mesh.vertices[mesh.indices[i + 2]].Position, 1.0f));
-
-               Triangle triangle(v0, v1, v2);
-               float triT;
-
-               if (RayTriangleIntersect(ray, triangle, triT) && triT > 0.01f && triT < lightDistance) {
-                  static int triangleHitCounter = 0;
-                  if (triangleHitCounter++ % 1000000 == 0) {
-                     std::cout << "\nTriangle intersection found:" << std::endl;
-                     std::cout << "Triangle vertices:" << std::endl;
-                     std::cout << "V0: [" << v0.x << ", " << v0.y << ", " << v0.z << "]" << std::endl;
-                     std::cout << "V1: [" << v1.x << ", " << v1.y << ", " << v1.z << "]" << std::endl;
-                     std::cout << "V2: [" << v2.x << ", " << v2.y << ", " << v2.z << "]" << std::endl;
-                     std::cout << "Intersection distance: " << triT << std::endl;
-                     std::cout << "Light distance: " << lightDistance << std::endl;
-                  }
-                  triangleHit = true;
-                  break; //  ,    
-               }
-            }
-            if (triangleHit) break; //    
-         }
-         if (triangleHit) return true; //   
-      }
+   if (argc > 1 && std::string(argv[1]) == "--bench-obj") {
+      return RunObjImportBenchmark(argc > 2 ? argv[2] : "");
+   }
+   if (argc > 2 && std::string(argv[1]) == "--prewarm-cache") {
+      MeshCachePrewarmStats stats = PrewarmMeshCache(argv[2]);
+      std::cout << "Mesh cache: " << stats.models << " models, " << stats.cached << " up to date, " << stats.built
+         << " built, " << stats.failed << " failed in " << stats.seconds << " s" << std::endl;
+      return stats.failed == 0 ? 0 : 1;
    }
-   return false; //  
-}
 
-int main()
-{
    glfwInit();
    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -181,10 +159,15 @@ int main()
       return -1;
    }
 
+   // BC4/BC5    GL 3.0, BC1/BC3  
+   GlobalTextureCompression().s3tc = GLExtensionSupported("GL_EXT_texture_compression_s3tc");
+
    glEnable(GL_DEPTH_TEST);
 
    //    Ray Tracing
    GLuint rayTracingTexture = CreateRayTracingTexture(RT_SHADOW_WIDTH, RT_SHADOW_HEIGHT);
+   //        
+   GBuffer gBuffer(RT_SHADOW_WIDTH, RT_SHADOW_HEIGHT);
 
    GLuint depthMapFBO;
    glGenFramebuffers(1, &depthMapFBO);
@@ -228,12 +211,11 @@ int main()
    Shader shaderNormalVertex("v_line_vertex_shader.glsl", "v_line_fragment_shader.glsl");
    Shader lightShader("light_vertex_shader.glsl", "light_fragment_shader.glsl");
    Shader mirrorShader("shaders/mirror.vs", "shaders/mirror.fs");
+   Shader gBufferShader("shaders/gbuffer.vs", "shaders/gbuffer.fs");
 
    static std::string modelPath = "resources/objects/Crate/Crate1.obj";
    Model ourModel(modelPath);
 
-   std::vector<glm::vec3> faceNormalLines;
-   std::vector<glm::vec3> vertexNormalLines;
 
 
    std::vector<Vertex> mirrorVertices = {
@@ -244,57 +226,19 @@ int main()
    };
    std::vector<unsigned int> mirrorIndices = { 0, 1, 2, 2, 3, 0 };
    std::vector<Texture> mirrorTextures; //   
-   Mesh mirrorMesh(mirrorVertices, mirrorIndices, mirrorTextures);
+   Mesh mirrorMesh(std::move(mirrorVertices), std::move(mirrorIndices), std::move(mirrorTextures));
    Model mirrorModel; //    
    mirrorModel.meshes.clear(); //    
-   mirrorModel.meshes.push_back(mirrorMesh); //   
+   mirrorModel.meshes.push_back(std::move(mirrorMesh)); //   
+   mirrorModel.BuildBVH(); //   ,  BVH    
+   mirrorModel.ComputeBounds();
    SceneObject mirror;
    mirror.name = "mirror"; //    
-   mirror.model = mirrorModel;
+   mirror.model = GlobalModelRegistry().Adopt(std::move(mirrorModel));
    mirror.position = glm::vec3(0.0f, 0.0f, -5.0f);
    mirror.scale = glm::vec3(2.0f, 2.0f, 1.0f);
-   sceneObjects.push_back(mirror);
-
-
-   for (auto& mesh : ourModel.meshes) {
-      for (size_t i = 0; i < mesh.indices.size(); i += 3) {
-         glm::vec3 v0 = mesh.vertices[mesh.indices[i]].Position;
-         glm::vec3 v1 = mesh.vertices[mesh.indices[i + 1]].Position;
-         glm::vec3 v2 = mesh.vertices[mesh.indices[i + 2]].Position;
-         glm::vec3 center = (v0 + v1 + v2) / 3.0f;
-         glm::vec3 normal = glm::normalize(glm::cross(v1 - v0, v2 - v0));
-
-         faceNormalLines.push_back(center);
-         faceNormalLines.push_back(center + normal * 0.8f);
-
-         for (int j = 0; j < 3; ++j) {
-            glm::vec3 pos = mesh.vertices[mesh.indices[i + j]].Position;
-            glm::vec3 norm = mesh.vertices[mesh.indices[i + j]].Normal;
-            vertexNormalLines.push_back(pos);
-            vertexNormalLines.push_back(pos + norm * 0.5f);
-         }
-      }
-   }
+   sceneObjects.push_back(mirror); //   (  ); mirror     
 
-   GLuint faceNormalsVAO, faceNormalsVBO;
-   glGenVertexArrays(1, &faceNormalsVAO);
-   glGenBuffers(1, &faceNormalsVBO);
-   glBindVertexArray(faceNormalsVAO);
-   glBindBuffer(GL_ARRAY_BUFFER, faceNormalsVBO);
-   glBufferData(GL_ARRAY_BUFFER, faceNormalLines.size() * sizeof(glm::vec3), faceNormalLines.data(), GL_STATIC_DRAW);
-   glEnableVertexAttribArray(0);
-   glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-   glBindVertexArray(0);
-
-   GLuint vertexNormalsVAO, vertexNormalsVBO;
-   glGenVertexArrays(1, &vertexNormalsVAO);
-   glGenBuffers(1, &vertexNormalsVBO);
-   glBindVertexArray(vertexNormalsVAO);
-   glBindBuffer(GL_ARRAY_BUFFER, vertexNormalsVBO);
-   glBufferData(GL_ARRAY_BUFFER, vertexNormalLines.size() * sizeof(glm::vec3), vertexNormalLines.data(), GL_STATIC_DRAW);
-   glEnableVertexAttribArray(0);
-   glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-   glBindVertexArray(0);
 
    //  VAO  VBO   
    std::vector<float> sphereVertices;
@@ -364,8 +308,37 @@ int main()
    float shininess = 8.0f;
 
    char modelPathInput[256] = "resources/objects/Crate/Crate1.obj";
+   bool compactVertices = false; //    (PackedVertex)   
+   int geometryResidency = GEOMETRY_RESIDENCY_POSITIONS; // CPU-   
    bool reloadModel = false;
 
+   //       
+   char prewarmPathInput[256] = "resources/objects";
+   std::atomic<bool> prewarmRunning{ false };
+   MeshCachePrewarmStats prewarmStats;
+   bool prewarmDone = false;
+
+   //   BVH   ,     
+   SceneBVH sceneBVH;
+
+   //       16x16   ,    
+   ShadowTracer shadowTracer(GlobalJobSystem(), RT_SHADOW_WIDTH, RT_SHADOW_HEIGHT, 16);
+   bool useGBufferHits = true; //       
+
+   //     CPU  GPU
+   FrameProfiler profiler;
+   bool showProfiler = false;
+
+   //   "Load Model"   ,  GPU -      
+   AssetLoader assetLoader(GlobalJobSystem());
+   //         ,   
+   InstanceRenderer instanceRenderer;
+   //    :     ,    ,   
+   bool frustumCulling = true;
+   InstanceRenderer::Stats shadowCullStats, mirrorCullStats, cameraCullStats;
+   auto allObjects = [](size_t) { return true; };
+   auto notMirror = [](size_t i) { return sceneObjects[i].name != "mirror"; };
+
    while (!glfwWindowShouldClose(window))
    {
       float currentFrame = glfwGetTime();
@@ -373,11 +346,35 @@ int main()
       lastFrame = currentFrame;
       processInput(window);
 
+      profiler.BeginFrame();
+      profiler.Begin("Asset upload");
+      assetLoader.ProcessUploads();
+      GlobalModelRegistry().CollectGarbage();
+      GlobalTextureCache().CollectGarbage();
+      for (int i = 0; i < static_cast<int>(sceneObjects.size()); ++i) {
+         SceneObject& obj = sceneObjects[i];
+         if (!obj.loading || !obj.loading->Finished()) continue;
+         if (obj.loading->State() == ASSET_LOAD_DONE) {
+            obj.model = obj.loading->TakeModel();
+            obj.loading.reset();
+            continue;
+         }
+         if (obj.loading->State() == ASSET_LOAD_FAILED)
+            LOG_ERROR("Failed to load model: %s", obj.loading->Path().c_str());
+         sceneObjects.erase(sceneObjects.begin() + i);
+         if (selectedObjectIndex == i) selectedObjectIndex = -1;
+         else if (selectedObjectIndex > i) selectedObjectIndex--;
+         --i;
+      }
+      profiler.End();
+
+      profiler.Begin("UI", false);
       ImGui_ImplOpenGL3_NewFrame();
       ImGui_ImplGlfw_NewFrame();
       ImGui::NewFrame();
 
       ImGui::Begin("Control Panel");
+      ImGui::Checkbox("Show Profiler", &showProfiler);
       ImGui::Text("Camera Settings");
       ImGui::Separator();
       if (editSceneMode) {
@@ -531,6 +528,30 @@ int main()
          }
       }
 
+      if (shadowMode == SHADOW_RAYTRACING) {
+         TileSchedulerStats rtStats = shadowTracer.LastStats();
+         ImGui::Indent();
+         ImGui::Checkbox("Reuse G-buffer hits", &useGBufferHits);
+         bool progressiveShadows = shadowTracer.Progressive();
+         if (ImGui::Checkbox("Progressive", &progressiveShadows)) {
+            shadowTracer.SetProgressive(progressiveShadows);
+         }
+         if (shadowTracer.Progressive()) {
+            int pass = shadowTracer.LastPass();
+            if (shadowTracer.Converged())
+               ImGui::Text("Pass: converged, tracing stopped");
+            else if (pass < PROGRESSIVE_REFINE_PASSES)
+               ImGui::Text("Pass: refine %u px", PROGRESSIVE_COARSE_STEP >> std::max(pass, 0));
+            else
+               ImGui::Text("Pass: accumulate %d/%d", pass - PROGRESSIVE_REFINE_PASSES + 1, PROGRESSIVE_ACCUMULATION_PASSES);
+         }
+         ImGui::Text("Rays: %d", shadowTracer.LastRayCount());
+         ImGui::Text("Threads: %u, tiles: %u, primary hits: %d", rtStats.threads, rtStats.tiles, shadowTracer.LastHitCount());
+         ImGui::Text("Trace: %.2f ms (tile min %.3f / avg %.3f / max %.3f ms)",
+            rtStats.totalMs, rtStats.minTileMs, rtStats.avgTileMs, rtStats.maxTileMs);
+         ImGui::Unindent();
+      }
+
       if (!shadowControlsEnabled) {
          ImGui::PopStyleVar();
          if (ImGui::IsItemHovered()) {
@@ -542,12 +563,57 @@ int main()
       ImGui::Separator();
       ImGui::InputText("Model Path", modelPathInput, IM_ARRAYSIZE(modelPathInput));
       if (ImGui::Button("Load Model")) {
-         try {
-            std::string name = std::filesystem::path(modelPathInput).filename().string();
-            sceneObjects.push_back({ name, Model(modelPathInput) });
+         // -  ,    
+         std::string name = std::filesystem::path(modelPathInput).filename().string();
+         SceneObject placeholder(name, EmptyModel());
+         placeholder.loading = assetLoader.Load(modelPathInput, compactVertices ? VERTEX_FORMAT_PACKED : VERTEX_FORMAT_FLOAT,
+            static_cast<GeometryResidency>(geometryResidency));
+         sceneObjects.push_back(std::move(placeholder));
+      }
+      ImGui::SameLine();
+      ImGui::Checkbox("Compact Vertices", &compactVertices);
+      if (ImGui::IsItemHovered())
+         ImGui::SetTooltip("20-byte vertices: 16-bit positions, 10:10:10:2 normals and tangents, half-float UVs");
+      const char* residencyItems[] = { "Full", "Positions + Normals", "None" };
+      ImGui::Combo("CPU Geometry", &geometryResidency, residencyItems, IM_ARRAYSIZE(residencyItems));
+      if (ImGui::IsItemHovered())
+         ImGui::SetTooltip("Geometry kept in RAM after GPU upload. Positions are enough for normal display, None disables it");
+      ModelRegistry::Stats modelStats = GlobalModelRegistry().GetStats();
+      ImGui::Text("Shared models: %zu (%zu references), reused %llu / loads %llu", modelStats.models, modelStats.references,
+         (unsigned long long)modelStats.hits, (unsigned long long)modelStats.misses);
+      ImGui::Text("CPU geometry: %.1f MB", modelStats.geometryBytes / (1024.0 * 1024.0));
+      ImGui::Text("Instancing: %zu objects in %zu batches, %zu draw calls", cameraCullStats.objects, cameraCullStats.batches, cameraCullStats.drawCalls);
+      ImGui::Checkbox("Frustum Culling", &frustumCulling);
+      const char* cullPassNames[] = { "Shadow", "Mirror", "Camera" };
+      const InstanceRenderer::Stats* cullPassStats[] = { &shadowCullStats, &mirrorCullStats, &cameraCullStats };
+      for (int pass = 0; pass < 3; ++pass)
+         ImGui::Text("%s: %zu visible, %zu objects culled, %zu meshes culled", cullPassNames[pass], cullPassStats[pass]->objects,
+            cullPassStats[pass]->culledObjects, cullPassStats[pass]->culledMeshes);
+      bool compressTextures = GlobalTextureCompression().enabled;
+      if (ImGui::Checkbox("Compress Textures (BC)", &compressTextures))
+         GlobalTextureCompression().enabled = compressTextures;
+      if (ImGui::IsItemHovered())
+         ImGui::SetTooltip("Applies to textures loaded after the change; compressed copies are cached in %s", TEXTURE_CACHE_DIRECTORY);
+      TextureCache::Stats textureStats = GlobalTextureCache().GetStats();
+      ImGui::Text("Shared textures: %zu (%.1f MB), cache hits %llu / loads %llu", textureStats.textures,
+         textureStats.bytes / (1024.0 * 1024.0), (unsigned long long)textureStats.hits, (unsigned long long)textureStats.misses);
+      ImGui::InputText("Cache Directory", prewarmPathInput, IM_ARRAYSIZE(prewarmPathInput));
+      if (prewarmRunning) {
+         ImGui::Text("Prewarming mesh cache...");
+      }
+      else {
+         if (ImGui::Button("Prewarm Mesh Cache")) {
+            prewarmRunning = true;
+            std::string root = prewarmPathInput;
+            GlobalJobSystem().Submit([&, root] {
+               prewarmStats = PrewarmMeshCache(root);
+               prewarmDone = true;
+               prewarmRunning = false;
+            });
          }
-         catch (const std::exception& e) {
-            std::cout << "Failed to load model: " << e.what() << std::endl;
+         if (prewarmDone) {
+            ImGui::Text("Cache: %u models, %u up to date, %u built, %u failed (%.2f s)", prewarmStats.models,
+               prewarmStats.cached, prewarmStats.built, prewarmStats.failed, prewarmStats.seconds);
          }
       }
       ImGui::End();
@@ -580,6 +646,21 @@ int main()
          ImGui::SameLine();
          ImGui::Text("%s", label.c_str());
 
+         ImGui::SameLine();
+         if (obj.loading) {
+            ImGui::ProgressBar(obj.loading->Progress(), ImVec2(120.0f, 0.0f), obj.loading->StateName());
+            ImGui::SameLine();
+            if (ImGui::Button(("Cancel##" + std::to_string(i)).c_str()))
+               obj.loading->Cancel();
+            continue;
+         }
+         //       ,   
+         if (ImGui::Button(("Duplicate##" + std::to_string(i)).c_str())) {
+            SceneObject copy = obj;
+            copy.position += glm::vec3(1.0f, 0.0f, 0.0f);
+            sceneObjects.push_back(std::move(copy));
+            break;
+         }
          ImGui::SameLine();
          if (ImGui::Button(("Delete##" + std::to_string(i)).c_str())) {
             sceneObjects.erase(sceneObjects.begin() + i);
@@ -591,53 +672,31 @@ int main()
 
       ImGui::End();
 
+      if (showProfiler) {
+         profiler.DrawImGui();
+      }
+      profiler.End();
+
       if (reloadModel) {
+         profiler.Begin("Model reload", false);
          try {
             ourModel = Model(modelPath);
-            faceNormalLines.clear();
-            vertexNormalLines.clear();
-            for (auto& mesh : ourModel.meshes) {
-               for (size_t i = 0; i < mesh.indices.size(); i += 3) {
-                  glm::vec3 v0 = mesh.vertices[mesh.indices[i]].Position;
-                  glm::vec3 v1 = mesh.vertices[mesh.indices[i + 1]].Position;
-                  glm::vec3 v2 = mesh.vertices[mesh.indices[i + 2]].Position;
-                  glm::vec3 center = (v0 + v1 + v2) / 3.0f;
-                  glm::vec3 normal = glm::normalize(glm::cross(v1 - v0, v2 - v0));
-
-                  faceNormalLines.push_back(center);
-                  faceNormalLines.push_back(center + normal * 0.8f);
-
-                  for (int j = 0; j < 3; ++j) {
-                     glm::vec3 pos = mesh.vertices[mesh.indices[i + j]].Position;
-                     glm::vec3 norm = mesh.vertices[mesh.indices[i + j]].Normal;
-                     vertexNormalLines.push_back(pos);
-                     vertexNormalLines.push_back(pos + norm * 0.5f);
-                  }
-               }
-            }
-            glBindVertexArray(faceNormalsVAO);
-            glBindBuffer(GL_ARRAY_BUFFER, faceNormalsVBO);
-            glBufferData(GL_ARRAY_BUFFER, faceNormalLines.size() * sizeof(glm::vec3), faceNormalLines.data(), GL_STATIC_DRAW);
-            glBindVertexArray(0);
-
-            glBindVertexArray(vertexNormalsVAO);
-            glBindBuffer(GL_ARRAY_BUFFER, vertexNormalsVBO);
-            glBufferData(GL_ARRAY_BUFFER, vertexNormalLines.size() * sizeof(glm::vec3), vertexNormalLines.data(), GL_STATIC_DRAW);
-            glBindVertexArray(0);
          }
          catch (const std::exception& e) {
             std::cout << "Failed to load model: " << e.what() << std::endl;
          }
          reloadModel = false;
+         profiler.End();
       }
 
+      profiler.Begin("Depth pass");
       glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
       glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
       glEnable(GL_POLYGON_OFFSET_FILL);
       glPolygonOffset(2.0f, 4.0f);
       glClear(GL_DEPTH_BUFFER_BIT);
 
-      glm::mat4 lightProjection, lightView, lightSpaceMatrix;
+      glm::mat4 lightProjection(1.0f), lightView(1.0f), lightSpaceMatrix;
       glm::vec3 sceneCenter = ComputeSceneCenter();
 
       if (lightingMode == DIRECTIONAL || lightingMode == POINT || lightingMode == SPOTLIGHT) {
@@ -649,36 +708,18 @@ int main()
       depthShader.use();
       depthShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
 
-      for (const SceneObject& obj : sceneObjects) {
-         glm::mat4 model = glm::mat4(1.0f);
-         if (cameraMode == FIGURE_ROTATION && editSceneMode && selectedObjectIndex == -1) {
-            glm::vec3 center = ComputeSceneCenter();
-            model = glm::translate(model, center);
-            model = glm::rotate(model, glm::radians(objectRotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-            model = glm::rotate(model, glm::radians(objectRotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-            model = glm::rotate(model, glm::radians(objectRotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-            model = glm::translate(model, -center);
-         }
-         else if (cameraMode == QUATERNION && editSceneMode && selectedObjectIndex == -1) {
-            glm::vec3 center = ComputeSceneCenter();
-            model = glm::translate(model, center);
-            model *= glm::mat4_cast(objectOrientation);
-            model = glm::translate(model, -center);
-         }
-         model = glm::translate(model, obj.position);
-         model = glm::rotate(model, glm::radians(obj.rotation.x), glm::vec3(1, 0, 0));
-         model = glm::rotate(model, glm::radians(obj.rotation.y), glm::vec3(0, 1, 0));
-         model = glm::rotate(model, glm::radians(obj.rotation.z), glm::vec3(0, 0, 1));
-         model = glm::scale(model, obj.scale);
-
-         depthShader.setMat4("model", model);
-         obj.model.Draw(depthShader);
-      }
+      glm::mat4 sceneRotation = ComputeSceneRotation();
+      Frustum lightFrustum = Frustum::FromMatrix(lightSpaceMatrix * sceneRotation);
+      instanceRenderer.Build(sceneObjects, sceneRotation, frustumCulling ? &lightFrustum : nullptr, allObjects);
+      instanceRenderer.Draw(depthShader);
+      shadowCullStats = instanceRenderer.LastStats();
       glBindFramebuffer(GL_FRAMEBUFFER, 0);
       glDisable(GL_POLYGON_OFFSET_FILL);
       glClearColor(backgroundColor.r, backgroundColor.g, backgroundColor.b, 1.0f);
+      profiler.End();
 
       // === 1.     (  mirror) ===
+      profiler.Begin("Mirror pass");
       glBindFramebuffer(GL_FRAMEBUFFER, mirrorFBO);
       glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
       glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -697,6 +738,11 @@ int main()
          }
       }
 
+      //     :   ,  
+      if (mirrorPtr && frustumCulling && !Frustum::FromMatrix(projection * camera.GetViewMatrix()).Overlaps(mirrorPtr->GetWorldBounds()))
+         mirrorPtr = nullptr;
+      mirrorCullStats = InstanceRenderer::Stats();
+
       if (mirrorPtr) {
          SceneObject& mirror = *mirrorPtr;
 
@@ -724,30 +770,18 @@ int main()
          reflectedView = glm::lookAt(reflectedCameraPos, reflectedCameraPos + reflectedFront, reflectedUp);
 
          // 5.      Z
-         std::cout << "Camera Z: " << cameraPos.z << std::endl;
-         std::cout << "Mirror Z: " << mirrorPoint.z << std::endl;
-         std::cout << "Normal Z: " << mirrorNormal.z << std::endl;
-         std::cout << "ReflectedCameraPos Z: " << reflectedCameraPos.z << std::endl;
+         LOG_RATE_LIMITED(LOG_LEVEL_DEBUG, 1000, "Mirror: camera Z %.3f, mirror Z %.3f, normal Z %.3f, reflected camera Z %.3f",
+            cameraPos.z, mirrorPoint.z, mirrorNormal.z, reflectedCameraPos.z);
 
 
          // 1.2       mirrorFBO
-         for (const SceneObject& obj : sceneObjects) {
-            if (obj.name == "mirror") continue; //      
-
-            ourShader.use();
-            ourShader.setMat4("projection", projection);
-            ourShader.setMat4("view", reflectedView);
-
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, obj.position);
-            model = glm::rotate(model, glm::radians(obj.rotation.x), glm::vec3(1, 0, 0));
-            model = glm::rotate(model, glm::radians(obj.rotation.y), glm::vec3(0, 1, 0));
-            model = glm::rotate(model, glm::radians(obj.rotation.z), glm::vec3(0, 0, 1));
-            model = glm::scale(model, obj.scale);
-
-            ourShader.setMat4("model", model);
-            obj.model.Draw(ourShader);
-         }
+         ourShader.use();
+         ourShader.setMat4("projection", projection);
+         ourShader.setMat4("view", reflectedView);
+         Frustum mirrorFrustum = Frustum::FromMatrix(projection * reflectedView);
+         instanceRenderer.Build(sceneObjects, glm::mat4(1.0f), frustumCulling ? &mirrorFrustum : nullptr, notMirror);
+         instanceRenderer.Draw(ourShader);
+         mirrorCullStats = instanceRenderer.LastStats();
 
          //      FBO
          glActiveTexture(GL_TEXTURE0);
@@ -755,8 +789,10 @@ int main()
       }
 
       glBindFramebuffer(GL_FRAMEBUFFER, 0);
+      profiler.End();
 
       // === 2.      ===
+      profiler.Begin("Main pass");
       glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
       glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
       glEnable(GL_DEPTH_TEST);
@@ -765,16 +801,18 @@ int main()
       glm::mat4 view = camera.GetViewMatrix();
       glm::mat4 reflectedProjection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
 
-      // 2.1    ( )
+      // 2.1    ( ).    ,  -  
+      ourShader.use();
+      ourShader.setMat4("view", view);
+      ourShader.setMat4("projection", projection);
+      Frustum cameraFrustum = Frustum::FromMatrix(projection * view);
+      instanceRenderer.Build(sceneObjects, glm::mat4(1.0f), frustumCulling ? &cameraFrustum : nullptr, notMirror);
+      instanceRenderer.Draw(ourShader);
+
       for (const SceneObject& obj : sceneObjects) {
-         glm::mat4 model = glm::mat4(1.0f);
-         model = glm::translate(model, obj.position);
-         model = glm::rotate(model, glm::radians(obj.rotation.x), glm::vec3(1, 0, 0));
-         model = glm::rotate(model, glm::radians(obj.rotation.y), glm::vec3(0, 1, 0));
-         model = glm::rotate(model, glm::radians(obj.rotation.z), glm::vec3(0, 0, 1));
-         model = glm::scale(model, obj.scale);
+         glm::mat4 model = obj.GetModelMatrix();
 
-         if (obj.name == "mirror") {
+         if (obj.name == "mirror" && (!frustumCulling || cameraFrustum.Overlaps(obj.GetWorldBounds()))) {
             //   (   )
             //  GL_TEXTURE1  mirrorTexture
             glActiveTexture(GL_TEXTURE1);
@@ -787,119 +825,85 @@ int main()
             mirrorShader.setMat4("reflectedProj", reflectedProjection);   //  
             mirrorShader.setInt("mirrorTexture", 1);            //     GL_TEXTURE1 //   1   
 
-            obj.model.Draw(mirrorShader);
-         }
-         else {
-            //  
-            ourShader.use();
-            ourShader.setMat4("model", model);
-            ourShader.setMat4("view", view);
-            ourShader.setMat4("projection", projection);
-            obj.model.Draw(ourShader);
+            obj.model->Draw(mirrorShader);
          }
       }
 
+      profiler.End();
+
       glm::mat4 invProjection = glm::inverse(projection);
       glm::mat4 invView = glm::inverse(view);
       // Ray Tracing
+      profiler.Begin("Ray trace");
       if (shadowMode == SHADOW_RAYTRACING && (lightingMode == POINT || lightingMode == SPOTLIGHT || lightingMode == DIRECTIONAL)) {
-         std::vector<unsigned char> shadowData(RT_SHADOW_WIDTH * RT_SHADOW_HEIGHT, 255);
-         static int hitCount = 0; //    
-         int localHitCount = 0; //     
-
-         #pragma omp parallel for collapse(2)
-         for (int y = 0; y < RT_SHADOW_HEIGHT; ++y) {
-            for (int x = 0; x < RT_SHADOW_WIDTH; ++x) {
-               float ndcX = (2.0f * x) / RT_SHADOW_WIDTH - 1.0f;
-               float ndcY = 1.0f - (2.0f * y) / RT_SHADOW_HEIGHT;
-
-               glm::vec4 clipPos = glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
-               glm::vec4 viewPos = invProjection * clipPos;
-               viewPos /= viewPos.w; //    
-               glm::vec4 worldPos = invView * viewPos;
-               worldPos /= worldPos.w;
-
-               glm::vec3 rayOrigin = camera.Position;
-               glm::vec3 rayDir = glm::normalize(glm::vec3(worldPos) - rayOrigin);
-               glm::vec3 hitPoint = rayOrigin;
-               float minT = std::numeric_limits<float>::max();
-               bool hit = false;
-               const SceneObject* hitObject = nullptr;
-
-               for (const auto& obj : sceneObjects) {
-                  glm::mat4 model = glm::mat4(1.0f);
-                  model = glm::translate(model, obj.position);
-                  model = glm::rotate(model, glm::radians(obj.rotation.x), glm::vec3(1, 0, 0));
-                  model = glm::rotate(model, glm::radians(obj.rotation.y), glm::vec3(0, 1, 0));
-                  model = glm::rotate(model, glm::radians(obj.rotation.z), glm::vec3(0, 0, 1));
-                  model = glm::scale(model, obj.scale);
-                  //std::cout << "Processing object: " << obj.name << ", Meshes count: " << obj.model.meshes.size() << std::endl;
-
-                  for (const auto& mesh : obj.model.meshes) {
-                     for (size_t i = 0; i < mesh.indices.size(); i += 3) {
-                        glm::vec3 v0 = glm::vec3(model * glm::vec4(mesh.vertices[mesh.indices[i]].Position, 1.0f));
-                        glm::vec3 v1 = glm::vec3(model * glm::vec4(mesh.vertices[mesh.indices[i + 1]].Position, 1.0f));
-                        glm::vec3 v2 = glm::vec3(model * glm::vec4(mesh.vertices[mesh.indices[i + 2]].Position, 1.0f));
-
-                        Triangle triangle(v0, v1, v2);
-                        float t;
-                        if (RayTriangleIntersect(Ray(rayOrigin, rayDir), triangle, t) && t > 0.001f && t < minT) {
-                           minT = t;
-                           hitPoint = rayOrigin + rayDir * t;
-                           hit = true;
-                           hitObject = &obj;
-                           //std::cout << "Hit object: " << obj.name << " at t = " << t << std::endl;
-                        }
-                     }
-                  }
-               }
-
-               bool inShadow = hit ? TraceShadowRay(hitPoint, lightPos, sceneObjects, hitObject) : false;
-               shadowData[y * RT_SHADOW_WIDTH + x] = inShadow ? 0 : 255;
-
-               //   
-               if (x == RT_SHADOW_WIDTH / 2 && y == RT_SHADOW_HEIGHT / 2) {
-                  std::cout << "Center pixel debug:" << std::endl;
-                  std::cout << "Ray origin: [" << rayOrigin.x << ", " << rayOrigin.y << ", " << rayOrigin.z << "]" << std::endl;
-                  std::cout << "Ray direction: [" << rayDir.x << ", " << rayDir.y << ", " << rayDir.z << "]" << std::endl;
-                  std::cout << "Hit: " << hit << std::endl;
-                  if (hit) {
-                     std::cout << "Hit point: [" << hitPoint.x << ", " << hitPoint.y << ", " << hitPoint.z << "]" << std::endl;
-                     std::cout << "Shadow ray direction: [" << glm::normalize(lightPos - hitPoint).x << ", "
-                        << glm::normalize(lightPos - hitPoint).y << ", "
-                        << glm::normalize(lightPos - hitPoint).z << "]" << std::endl;
-                     std::cout << "In shadow: " << inShadow << std::endl;
-                  }
-               }
+         UpdateSceneBVH(sceneBVH, sceneObjects);
 
-               if (hit) {
-                  #pragma omp atomic
-                  localHitCount++;
+         //             .
+         //   ,      
+         if (shadowTracer.UploadIfReady(rayTracingTexture)) {
+            profiler.AddValue("Ray trace (async)", shadowTracer.LastStats().totalMs);
+         }
+         //         : G-     ,   
+         bool upToDate = shadowTracer.ConvergedFor(invProjection, invView, camera.Position, lightPos, sceneBVH, useGBufferHits);
+         if (useGBufferHits && !upToDate) {
+            //     G-,      ,   ,
+            //    :       .
+            //  G- ,         
+            GBufferFrame frame;
+            if (gBuffer.Fetch(frame) && !shadowTracer.Busy()) {
+               ShadowTraceSnapshot snapshot;
+               snapshot.invProjection = frame.invProjection;
+               snapshot.invView = frame.invView;
+               snapshot.cameraPos = frame.cameraPos;
+               snapshot.lightPos = lightPos;
+               snapshot.scene = std::move(frame.scene);
+               snapshot.gBuffer = frame.samples;
+               shadowTracer.Start(std::move(snapshot));
+            }
+            else if (!shadowTracer.Busy() && !gBuffer.Pending()) {
+               gBuffer.Bind();
+               gBufferShader.use();
+               gBufferShader.setMat4("projection", projection);
+               gBufferShader.setMat4("view", view);
+               gBufferShader.setVec3("viewPos", camera.Position);
+               for (size_t i = 0; i < sceneObjects.size(); ++i) {
+                  if (frustumCulling && !cameraFrustum.Overlaps(sceneObjects[i].GetWorldBounds())) continue;
+                  gBufferShader.setMat4("model", sceneObjects[i].GetModelMatrix());
+                  gBufferShader.setFloat("objectId", static_cast<float>(i + 1));
+                  sceneObjects[i].model->Draw(gBufferShader);
                }
+               gBuffer.Capture(invProjection, invView, camera.Position, sceneBVH);
+               glBindFramebuffer(GL_FRAMEBUFFER, 0);
+               glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+               glClearColor(backgroundColor.r, backgroundColor.g, backgroundColor.b, 1.0f);
             }
          }
+         else if (!useGBufferHits && !upToDate && !shadowTracer.Busy()) {
+            ShadowTraceSnapshot snapshot;
+            snapshot.invProjection = invProjection;
+            snapshot.invView = invView;
+            snapshot.cameraPos = camera.Position;
+            snapshot.lightPos = lightPos;
+            snapshot.scene = sceneBVH;
+            shadowTracer.Start(std::move(snapshot));
+         }
 
-         hitCount = localHitCount; //   
-         glBindTexture(GL_TEXTURE_2D, rayTracingTexture); //   
-         glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, RT_SHADOW_WIDTH, RT_SHADOW_HEIGHT, GL_RED, GL_UNSIGNED_BYTE, shadowData.data());
-         glFinish();
-
-         static int objectDebugCounter = 0;
-         if (objectDebugCounter++ % 60 == 0) {
-            std::cout << "Light position: [" << lightPos.x << ", " << lightPos.y << ", " << lightPos.z << "]" << std::endl;
-            std::cout << "Camera position: [" << camera.Position.x << ", " << camera.Position.y << ", " << camera.Position.z << "]" << std::endl;
-            std::cout << "Scene objects (" << sceneObjects.size() << "):" << std::endl;
+         static LogRateLimiter sceneLogLimiter(2000);
+         if (LOG_ENABLED(LOG_LEVEL_DEBUG) && sceneLogLimiter.Allow()) {
+            LOG_DEBUG("Light position: [%.3f, %.3f, %.3f], camera position: [%.3f, %.3f, %.3f], scene objects: %zu",
+               lightPos.x, lightPos.y, lightPos.z, camera.Position.x, camera.Position.y, camera.Position.z, sceneObjects.size());
             for (size_t i = 0; i < sceneObjects.size(); ++i) {
                const auto& obj = sceneObjects[i];
-               std::cout << "Object " << i << " (" << obj.name << "): Position ["
-                  << obj.position.x << ", " << obj.position.y << ", " << obj.position.z
-                  << "], Scale [" << obj.scale.x << ", " << obj.scale.y << ", " << obj.scale.z
-                  << std::endl;
+               LOG_DEBUG("Object %zu (%s): position [%.3f, %.3f, %.3f], scale [%.3f, %.3f, %.3f]", i, obj.name.c_str(),
+                  obj.position.x, obj.position.y, obj.position.z, obj.scale.x, obj.scale.y, obj.scale.z);
             }
          }
 
       }
+      profiler.End();
 
+      profiler.Begin("Lit pass");
+      ourShader.use();
       ourShader.setMat4("projection", projection);
       ourShader.setMat4("view", view);
       ourShader.setInt("lightingMode", static_cast<int>(lightingMode));
@@ -937,31 +941,10 @@ int main()
          ourShader.setInt("shadowMap", SHADOW_TEX_UNIT);
       }
 
-      for (const SceneObject& obj : sceneObjects) {
-         glm::mat4 model = glm::mat4(1.0f);
-         if (cameraMode == FIGURE_ROTATION && editSceneMode && selectedObjectIndex == -1) {
-            glm::vec3 center = ComputeSceneCenter();
-            model = glm::translate(model, center);
-            model = glm::rotate(model, glm::radians(objectRotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-            model = glm::rotate(model, glm::radians(objectRotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-            model = glm::rotate(model, glm::radians(objectRotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-            model = glm::translate(model, -center);
-         }
-         else if (cameraMode == QUATERNION && editSceneMode && selectedObjectIndex == -1) {
-            glm::vec3 center = ComputeSceneCenter();
-            model = glm::translate(model, center);
-            model *= glm::mat4_cast(objectOrientation);
-            model = glm::translate(model, -center);
-         }
-         model = glm::translate(model, obj.position);
-         model = glm::rotate(model, glm::radians(obj.rotation.x), glm::vec3(1, 0, 0));
-         model = glm::rotate(model, glm::radians(obj.rotation.y), glm::vec3(0, 1, 0));
-         model = glm::rotate(model, glm::radians(obj.rotation.z), glm::vec3(0, 0, 1));
-         model = glm::scale(model, obj.scale);
-
-         ourShader.setMat4("model", model);
-         obj.model.Draw(ourShader);
-      }
+      Frustum rotatedCameraFrustum = Frustum::FromMatrix(projection * view * sceneRotation);
+      instanceRenderer.Build(sceneObjects, sceneRotation, frustumCulling ? &rotatedCameraFrustum : nullptr, allObjects);
+      instanceRenderer.Draw(ourShader);
+      cameraCullStats = instanceRenderer.LastStats();
 
       if (lightingMode == POINT || lightingMode == SPOTLIGHT || lightingMode == DIRECTIONAL) {
          lightShader.use();
@@ -975,104 +958,37 @@ int main()
          glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(sphereIndices.size()), GL_UNSIGNED_INT, 0);
          glBindVertexArray(0);
       }
+      profiler.End();
 
-
-
+      profiler.Begin("Normal lines");
       if (editSceneMode && (displayMode == FACE_NORMALS || displayMode == VERTEX_NORMALS)) {
-         std::vector<glm::vec3> allFaceNormalLines;
-         std::vector<glm::vec3> allVertexNormalLines;
+         //         ,     
+         const Shader& lineShader = displayMode == FACE_NORMALS ? shaderNormalFace : shaderNormalVertex;
+         lineShader.use();
+         lineShader.setMat4("projection", projection);
+         lineShader.setMat4("view", view);
 
          for (const SceneObject& obj : sceneObjects) {
-            glm::mat4 model = glm::mat4(1.0f);
-            if (cameraMode == FIGURE_ROTATION && editSceneMode && selectedObjectIndex == -1) {
-               glm::vec3 center = ComputeSceneCenter();
-               model = glm::translate(model, center);
-               model = glm::rotate(model, glm::radians(objectRotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-               model = glm::rotate(model, glm::radians(objectRotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-               model = glm::rotate(model, glm::radians(objectRotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-               model = glm::translate(model, -center);
-            }
-            else if (cameraMode == QUATERNION && editSceneMode && selectedObjectIndex == -1) {
-               glm::vec3 center = ComputeSceneCenter();
-               model = glm::translate(model, center);
-               model *= glm::mat4_cast(objectOrientation);
-               model = glm::translate(model, -center);
-            }
-            model = glm::translate(model, obj.position);
-            model = glm::rotate(model, glm::radians(obj.rotation.x), glm::vec3(1, 0, 0));
-            model = glm::rotate(model, glm::radians(obj.rotation.y), glm::vec3(0, 1, 0));
-            model = glm::rotate(model, glm::radians(obj.rotation.z), glm::vec3(0, 0, 1));
-            model = glm::scale(model, obj.scale);
-
-            std::vector<glm::vec3> faceNormalLines;
-            std::vector<glm::vec3> vertexNormalLines;
-
-            for (auto& mesh : obj.model.meshes) {
-               for (size_t i = 0; i < mesh.indices.size(); i += 3) {
-                  glm::vec3 v0 = mesh.vertices[mesh.indices[i]].Position;
-                  glm::vec3 v1 = mesh.vertices[mesh.indices[i + 1]].Position;
-                  glm::vec3 v2 = mesh.vertices[mesh.indices[i + 2]].Position;
-                  glm::vec3 center = (v0 + v1 + v2) / 3.0f;
-                  glm::vec3 normal = glm::normalize(glm::cross(v1 - v0, v2 - v0));
-
-                  glm::vec4 transformedCenter = model * glm::vec4(center, 1.0f);
-                  glm::vec4 transformedNormal = model * glm::vec4(normal, 0.0f);
-                  faceNormalLines.push_back(glm::vec3(transformedCenter) / transformedCenter.w);
-                  faceNormalLines.push_back(glm::vec3(transformedCenter + transformedNormal * 0.8f) / transformedCenter.w);
-
-                  for (int j = 0; j < 3; ++j) {
-                     glm::vec3 pos = mesh.vertices[mesh.indices[i + j]].Position;
-                     glm::vec3 norm = mesh.vertices[mesh.indices[i + j]].Normal;
-                     glm::vec4 transformedPos = model * glm::vec4(pos, 1.0f);
-                     glm::vec4 transformedNorm = model * glm::vec4(norm, 0.0f);
-                     vertexNormalLines.push_back(glm::vec3(transformedPos) / transformedPos.w);
-                     vertexNormalLines.push_back(glm::vec3(transformedPos + transformedNorm * 0.5f) / transformedPos.w);
-                  }
-               }
-            }
-
-            allFaceNormalLines.insert(allFaceNormalLines.end(), faceNormalLines.begin(), faceNormalLines.end());
-            allVertexNormalLines.insert(allVertexNormalLines.end(), vertexNormalLines.begin(), vertexNormalLines.end());
-         }
-
-         if (!allFaceNormalLines.empty()) {
-            glBindVertexArray(faceNormalsVAO);
-            glBindBuffer(GL_ARRAY_BUFFER, faceNormalsVBO);
-            glBufferData(GL_ARRAY_BUFFER, allFaceNormalLines.size() * sizeof(glm::vec3), allFaceNormalLines.data(), GL_STREAM_DRAW);
-         }
+            if (frustumCulling && !rotatedCameraFrustum.Overlaps(obj.GetWorldBounds())) continue;
+            glm::mat4 model = sceneRotation * obj.GetModelMatrix();
 
-         if (!allVertexNormalLines.empty()) {
-            glBindVertexArray(vertexNormalsVAO);
-            glBindBuffer(GL_ARRAY_BUFFER, vertexNormalsVBO);
-            glBufferData(GL_ARRAY_BUFFER, allVertexNormalLines.size() * sizeof(glm::vec3), allVertexNormalLines.data(), GL_STREAM_DRAW);
-         }
-
-         if (displayMode == FACE_NORMALS) {
-            shaderNormalFace.use();
-            shaderNormalFace.setMat4("projection", projection);
-            shaderNormalFace.setMat4("view", view);
-            shaderNormalFace.setMat4("model", glm::mat4(1.0f));
-            glBindVertexArray(faceNormalsVAO);
-            glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(allFaceNormalLines.size()));
-            glBindVertexArray(0);
-         }
-
-         if (displayMode == VERTEX_NORMALS) {
-            shaderNormalVertex.use();
-            shaderNormalVertex.setMat4("projection", projection);
-            shaderNormalVertex.setMat4("view", view);
-            shaderNormalVertex.setMat4("model", glm::mat4(1.0f));
-            glBindVertexArray(vertexNormalsVAO);
-            glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(allVertexNormalLines.size()));
-            glBindVertexArray(0);
+            lineShader.setMat4("model", model);
+            obj.model->DrawNormals(displayMode == FACE_NORMALS);
          }
       }
 
+      profiler.End();
+
+      profiler.Begin("ImGui");
       ImGui::Render();
       ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+      profiler.End();
 
+      profiler.Begin("Swap", false);
       glfwSwapBuffers(window);
       glfwPollEvents();
+      profiler.End();
+      profiler.EndFrame();
    }
 
    glDeleteFramebuffers(1, &depthMapFBO);
@@ -1080,10 +996,13 @@ int main()
    glDeleteVertexArrays(1, &sphereVAO);
    glDeleteBuffers(1, &sphereVBO);
    glDeleteBuffers(1, &sphereEBO);
-   glDeleteVertexArrays(1, &faceNormalsVAO);
-   glDeleteBuffers(1, &faceNormalsVBO);
-   glDeleteVertexArrays(1, &vertexNormalsVAO);
-   glDeleteBuffers(1, &vertexNormalsVBO);
+   while (prewarmRunning) std::this_thread::yield();
+   assetLoader.WaitIdle();
+   shadowTracer.Wait();
+   shadowTracer.ReleaseGL();
+   instanceRenderer.ReleaseGL();
+   gBuffer.Release();
+   profiler.Release();
    if (rayTracingTexture) {
       glDeleteTextures(1, &rayTracingTexture);
    }
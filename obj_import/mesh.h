@@ -6,9 +6,13 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/packing.hpp>
 
 #include "shader.h" // shader.h   shader_s.h
+#include "geometry.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <string>
 #include <vector>
 using namespace std;
@@ -31,6 +35,30 @@ struct Vertex {
    glm::vec3 Bitangent;
 };
 
+//    GPU.    ; CPU-     Vertex
+enum VertexFormat { VERTEX_FORMAT_FLOAT, VERTEX_FORMAT_PACKED };
+
+//   (20   56).  - unorm16  AABB ,
+//     - snorm 10_10_10_2 (w  -  ),
+//   - half.    cross(N, T.xyz) * T.w
+struct PackedVertex {
+   uint16_t Position[4]; //   - 
+   uint32_t Normal;
+   uint32_t Tangent;
+   uint32_t TexCoords;
+};
+
+//     CPU     GPU (Mesh::ReleaseGeometry).
+// BVH     ,   CPU-  
+enum GeometryResidency {
+   GEOMETRY_RESIDENCY_FULL,      //  
+   GEOMETRY_RESIDENCY_POSITIONS, // ,    -   
+   GEOMETRY_RESIDENCY_NONE
+};
+
+//     (mat4)      
+const GLuint INSTANCE_MATRIX_ATTRIBUTE = 5;
+
 struct Texture {
    unsigned int id;
    string type;
@@ -43,15 +71,24 @@ public:
    vector<Vertex> vertices;
    vector<unsigned int> indices;
    vector<Texture> textures;
+   vector<glm::vec3> positions; //    ReleaseGeometry(GEOMETRY_RESIDENCY_POSITIONS); vertices   
+   vector<glm::vec3> normals;   //    ,    
+   unsigned int indexCount = 0; //    EBO,    CPU-
    unsigned int VAO;
    bool noTextures = false; // , ,     
+   VertexFormat format = VERTEX_FORMAT_FLOAT;
+   //    : aPos * positionScale + positionOffset ( VERTEX_FORMAT_FLOAT - 1  0)
+   glm::vec3 positionScale = glm::vec3(1.0f);
+   glm::vec3 positionOffset = glm::vec3(0.0f);
+   AABB bounds; //     ,        CPU-
 
    // 
-   Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+   Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, VertexFormat format = VERTEX_FORMAT_FLOAT)
    {
-      this->vertices = vertices;
-      this->indices = indices;
-      this->textures = textures;
+      this->vertices = std::move(vertices);
+      this->indices = std::move(indices);
+      this->textures = std::move(textures);
+      this->format = format;
 
       // ,       ,      
       setupMesh();
@@ -59,6 +96,69 @@ public:
 
    //  
    void Draw(const Shader& shader, bool useTextures, int reservedTextureUnit = -1) const {
+      bindMaterial(shader, useTextures, reservedTextureUnit);
+
+      //  
+      glBindVertexArray(VAO);
+      glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, 0);
+      glBindVertexArray(0);
+   }
+
+   //  instanceCount  .     instanceBuffer ,   firstInstance;
+   //      INSTANCE_MATRIX_ATTRIBUTE..+3
+   void DrawInstanced(const Shader& shader, bool useTextures, GLuint instanceBuffer, GLsizei firstInstance, GLsizei instanceCount,
+      int reservedTextureUnit = -1) const {
+      bindMaterial(shader, useTextures, reservedTextureUnit);
+
+      glBindVertexArray(VAO);
+      glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+      for (GLuint column = 0; column < 4; ++column) {
+         GLuint attribute = INSTANCE_MATRIX_ATTRIBUTE + column;
+         glEnableVertexAttribArray(attribute);
+         glVertexAttribPointer(attribute, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+            (void*)(firstInstance * sizeof(glm::mat4) + column * sizeof(glm::vec4)));
+         glVertexAttribDivisor(attribute, 1);
+      }
+      glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, 0, instanceCount);
+      glBindVertexArray(0);
+   }
+
+   //  CPU- ,    GPU.      
+   void ReleaseGeometry(GeometryResidency residency) {
+      if (residency == GEOMETRY_RESIDENCY_FULL) return;
+      if (residency == GEOMETRY_RESIDENCY_POSITIONS && positions.empty()) {
+         positions.resize(vertices.size());
+         normals.resize(vertices.size());
+         for (size_t i = 0; i < vertices.size(); ++i) {
+            positions[i] = vertices[i].Position;
+            normals[i] = vertices[i].Normal;
+         }
+      }
+      if (residency == GEOMETRY_RESIDENCY_NONE) {
+         vector<glm::vec3>().swap(positions);
+         vector<glm::vec3>().swap(normals);
+         vector<unsigned int>().swap(indices);
+      }
+      vector<Vertex>().swap(vertices);
+   }
+
+   //  CPU-   
+   size_t GeometryBytes() const {
+      return vertices.capacity() * sizeof(Vertex) + (positions.capacity() + normals.capacity()) * sizeof(glm::vec3) +
+         indices.capacity() * sizeof(unsigned int);
+   }
+
+   //  GL- ,      
+   void ReleaseGL() {
+      glDeleteVertexArrays(1, &VAO);
+      glDeleteBuffers(1, &VBO);
+      glDeleteBuffers(1, &EBO);
+      VAO = VBO = EBO = 0;
+   }
+
+private:
+   //  (   )    
+   void bindMaterial(const Shader& shader, bool useTextures, int reservedTextureUnit) const {
       if (useTextures) {
          //   
          unsigned int diffuseNr = 1;
@@ -95,13 +195,10 @@ public:
 
       }
 
-      //  
-      glBindVertexArray(VAO);
-      glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-      glBindVertexArray(0);
+      shader.setVec3("positionScale", positionScale);
+      shader.setVec3("positionOffset", positionOffset);
    }
 
-private:
    //    
    unsigned int VBO, EBO;
 
@@ -114,10 +211,19 @@ private:
       glGenBuffers(1, &EBO);
 
       glBindVertexArray(VAO);
+      indexCount = static_cast<unsigned int>(indices.size());
+      for (const Vertex& vertex : vertices)
+         bounds.Grow(vertex.Position);
 
       //     
       glBindBuffer(GL_ARRAY_BUFFER, VBO);
 
+      if (format == VERTEX_FORMAT_PACKED) {
+         setupPackedVertices();
+         glBindVertexArray(0);
+         return;
+      }
+
       //     ,         .
       //     ,        ,           glm::vec3 ( glm::vec2),        float,        
       glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
@@ -149,5 +255,61 @@ private:
 
       glBindVertexArray(0);
    }
+
+   //    PackedVertex     . VAO  VBO  .
+   //     vec3/vec2:     
+   void setupPackedVertices()
+   {
+      glm::vec3 minPos(0.0f), maxPos(0.0f);
+      if (!vertices.empty()) minPos = maxPos = vertices[0].Position;
+      for (const Vertex& vertex : vertices) {
+         minPos = glm::min(minPos, vertex.Position);
+         maxPos = glm::max(maxPos, vertex.Position);
+      }
+      positionOffset = minPos;
+      positionScale = glm::max(maxPos - minPos, glm::vec3(1e-6f));
+
+      vector<PackedVertex> packed(vertices.size());
+      for (size_t i = 0; i < vertices.size(); ++i) {
+         const Vertex& vertex = vertices[i];
+         PackedVertex& out = packed[i];
+         glm::vec3 position = glm::clamp((vertex.Position - positionOffset) / positionScale, 0.0f, 1.0f);
+         auto quantized = glm::packUnorm<uint16_t>(glm::vec4(position, 0.0f));
+         for (int c = 0; c < 4; ++c) out.Position[c] = quantized[c];
+
+         out.Normal = glm::packSnorm3x10_1x2(glm::vec4(SafeNormalize(vertex.Normal), 0.0f));
+         float handedness = glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.Bitangent) < 0.0f ? -1.0f : 1.0f;
+         out.Tangent = glm::packSnorm3x10_1x2(glm::vec4(SafeNormalize(vertex.Tangent), handedness));
+         out.TexCoords = glm::packHalf2x16(vertex.TexCoords);
+      }
+      glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(PackedVertex), packed.data(), GL_STATIC_DRAW);
+
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+      //  :  AABB , [0, 1]
+      glEnableVertexAttribArray(0);
+      glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Position));
+
+      //  
+      glEnableVertexAttribArray(1);
+      glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Normal));
+
+      //   
+      glEnableVertexAttribArray(2);
+      glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, TexCoords));
+
+      //     
+      glEnableVertexAttribArray(3);
+      glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Tangent));
+
+      //     
+      glDisableVertexAttribArray(4);
+   }
+
+   static glm::vec3 SafeNormalize(const glm::vec3& v) {
+      float length2 = glm::dot(v, v);
+      return length2 > 0.0f ? v / std::sqrt(length2) : glm::vec3(0.0f);
+   }
 };
 #endif
\ No newline at end of file
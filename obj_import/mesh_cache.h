@@ -0,0 +1,396 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include "mesh.h"
+#include "log.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//   :   Vertex/     .
+//             Assimp'.
+//
+//  (  little-endian,   4):
+//   MeshCacheHeader
+//      (pathLength ,   4)
+//   dependencyCount x { MeshCacheDependencyHeader, ,   4 }
+//   meshCount x { MeshCacheMeshHeader,   , vertexCount x Vertex, indexCount x uint32 }
+//   : uint32  , uint32  , ,   4
+
+const uint32_t MESH_CACHE_MAGIC = 0x4843534D; // "MSCH"
+const uint32_t MESH_CACHE_VERSION = 7;        //     ,  Vertex    
+const char* const MESH_CACHE_DIRECTORY = "cache/meshes";
+const uint64_t MESH_CACHE_MISSING_FILE = ~0ull; //  ,      
+
+//    :   (texture_diffuse, ...)    
+struct MeshTextureRef {
+   string type;
+   string path;
+};
+
+//     GL-
+struct MeshData {
+   vector<Vertex> vertices;
+   vector<unsigned int> indices;
+   vector<MeshTextureRef> textures;
+};
+
+struct MeshCacheHeader {
+   uint32_t magic;
+   uint32_t version;
+   uint32_t vertexSize;   // sizeof(Vertex)   
+   uint32_t importFlags;  //   Assimp
+   uint64_t sourceSize;
+   int64_t sourceTime;    //   
+   uint32_t meshCount;
+   uint32_t pathLength;
+   uint32_t dependencyCount;
+   uint32_t reserved;
+};
+
+struct MeshCacheDependencyHeader {
+   uint64_t size;
+   int64_t time;
+   uint32_t pathLength;
+   uint32_t reserved;
+};
+
+struct MeshCacheMeshHeader {
+   uint32_t vertexCount;
+   uint32_t indexCount;
+   uint32_t textureCount;
+   uint32_t reserved;
+};
+
+// ,      
+class MappedFile {
+public:
+   MappedFile() = default;
+   ~MappedFile() { Close(); }
+
+   MappedFile(const MappedFile&) = delete;
+   MappedFile& operator=(const MappedFile&) = delete;
+
+   bool Open(const string& path) {
+      Close();
+#ifdef _WIN32
+      file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+      if (file == INVALID_HANDLE_VALUE) return false;
+      LARGE_INTEGER fileSize;
+      if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) { Close(); return false; }
+      mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+      if (!mapping) { Close(); return false; }
+      data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+      if (!data) { Close(); return false; }
+      size = static_cast<size_t>(fileSize.QuadPart);
+#else
+      int fd = open(path.c_str(), O_RDONLY);
+      if (fd < 0) return false;
+      struct stat st;
+      if (fstat(fd, &st) != 0 || st.st_size == 0) { close(fd); return false; }
+      void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      close(fd);
+      if (mapped == MAP_FAILED) return false;
+      madvise(mapped, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+      data = static_cast<const uint8_t*>(mapped);
+      size = static_cast<size_t>(st.st_size);
+#endif
+      return true;
+   }
+
+   void Close() {
+#ifdef _WIN32
+      if (data) UnmapViewOfFile(data);
+      if (mapping) CloseHandle(mapping);
+      if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+      mapping = NULL;
+      file = INVALID_HANDLE_VALUE;
+#else
+      if (data) munmap(const_cast<uint8_t*>(data), size);
+#endif
+      data = nullptr;
+      size = 0;
+   }
+
+   const uint8_t* Data() const { return data; }
+   size_t Size() const { return size; }
+
+private:
+   const uint8_t* data = nullptr;
+   size_t size = 0;
+#ifdef _WIN32
+   HANDLE file = INVALID_HANDLE_VALUE;
+   HANDLE mapping = NULL;
+#endif
+};
+
+// ,        (  OBJ)
+struct MeshCacheDependency {
+   string path;
+   uint64_t size = MESH_CACHE_MISSING_FILE;
+   int64_t time = 0;
+};
+
+//   :  ,    .
+//      :        
+struct MeshCacheKey {
+   string sourcePath;
+   uint64_t sourceSize = 0;
+   int64_t sourceTime = 0;
+   uint32_t importFlags = 0;
+   vector<MeshCacheDependency> dependencies;
+};
+
+//      .    ,
+//   ,   
+inline MeshCacheDependency MakeMeshCacheDependency(const string& path) {
+   MeshCacheDependency dependency;
+   dependency.path = path;
+   std::error_code ec;
+   uintmax_t fileSize = std::filesystem::file_size(path, ec);
+   if (ec) return dependency;
+   auto fileTime = std::filesystem::last_write_time(path, ec);
+   if (ec) return dependency;
+   dependency.size = static_cast<uint64_t>(fileSize);
+   dependency.time = static_cast<int64_t>(fileTime.time_since_epoch().count());
+   return dependency;
+}
+
+inline bool MakeMeshCacheKey(const string& path, uint32_t importFlags, MeshCacheKey& key) {
+   std::error_code ec;
+   std::filesystem::path source = std::filesystem::absolute(path, ec).lexically_normal();
+   if (ec) return false;
+   uintmax_t fileSize = std::filesystem::file_size(source, ec);
+   if (ec) return false;
+   auto fileTime = std::filesystem::last_write_time(source, ec);
+   if (ec) return false;
+
+   key.sourcePath = source.generic_string();
+   key.sourceSize = static_cast<uint64_t>(fileSize);
+   key.sourceTime = static_cast<int64_t>(fileTime.time_since_epoch().count());
+   key.importFlags = importFlags;
+   return true;
+}
+
+//    - FNV-1a    ;      
+inline string MeshCacheFilePath(const MeshCacheKey& key) {
+   uint64_t hash = 14695981039346656037ull;
+   for (unsigned char c : key.sourcePath) {
+      hash ^= c;
+      hash *= 1099511628211ull;
+   }
+   hash ^= key.importFlags;
+   hash *= 1099511628211ull;
+
+   char name[32];
+   snprintf(name, sizeof(name), "%016llx.mesh", static_cast<unsigned long long>(hash));
+   return string(MESH_CACHE_DIRECTORY) + "/" + name;
+}
+
+//        
+class MeshCacheReader {
+public:
+   MeshCacheReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+   bool Read(void* out, size_t bytes) {
+      if (bytes > size - offset) return false;
+      memcpy(out, data + offset, bytes);
+      offset += bytes;
+      return true;
+   }
+
+   bool ReadString(uint32_t length, string& out) {
+      if (length > size - offset) return false;
+      out.assign(reinterpret_cast<const char*>(data + offset), length);
+      offset += length;
+      return true;
+   }
+
+   bool Align4() {
+      size_t aligned = (offset + 3) & ~size_t(3);
+      if (aligned > size) return false;
+      offset = aligned;
+      return true;
+   }
+
+   bool AtEnd() const { return offset == size; }
+
+private:
+   const uint8_t* data;
+   size_t size;
+   size_t offset = 0;
+};
+
+//  ,      .     - 
+inline bool ReadMeshCache(const MeshCacheKey& key, vector<MeshData>& meshes) {
+   MappedFile file;
+   if (!file.Open(MeshCacheFilePath(key))) return false;
+
+   MeshCacheReader reader(file.Data(), file.Size());
+   MeshCacheHeader header;
+   if (!reader.Read(&header, sizeof(header))) return false;
+   if (header.magic != MESH_CACHE_MAGIC || header.version != MESH_CACHE_VERSION || header.vertexSize != sizeof(Vertex) ||
+      header.importFlags != key.importFlags || header.sourceSize != key.sourceSize || header.sourceTime != key.sourceTime)
+      return false;
+
+   string sourcePath;
+   if (!reader.ReadString(header.pathLength, sourcePath) || sourcePath != key.sourcePath || !reader.Align4()) return false;
+
+   if (header.dependencyCount > file.Size() / sizeof(MeshCacheDependencyHeader)) return false;
+   for (uint32_t d = 0; d < header.dependencyCount; ++d) {
+      MeshCacheDependencyHeader dependencyHeader;
+      string dependencyPath;
+      if (!reader.Read(&dependencyHeader, sizeof(dependencyHeader)) || !reader.ReadString(dependencyHeader.pathLength, dependencyPath) ||
+         !reader.Align4())
+         return false;
+      MeshCacheDependency current = MakeMeshCacheDependency(dependencyPath);
+      if (current.size != dependencyHeader.size || current.time != dependencyHeader.time) return false;
+   }
+
+   if (header.meshCount > file.Size() / sizeof(MeshCacheMeshHeader)) return false;
+   vector<MeshData> loaded(header.meshCount);
+   for (MeshData& mesh : loaded) {
+      MeshCacheMeshHeader meshHeader;
+      if (!reader.Read(&meshHeader, sizeof(meshHeader))) return false;
+
+      if (meshHeader.textureCount > file.Size() / 8) return false;
+      mesh.textures.resize(meshHeader.textureCount);
+      for (MeshTextureRef& texture : mesh.textures) {
+         uint32_t lengths[2];
+         if (!reader.Read(lengths, sizeof(lengths)) || !reader.ReadString(lengths[0], texture.type) ||
+            !reader.ReadString(lengths[1], texture.path) || !reader.Align4())
+            return false;
+      }
+
+      //     ,        resize
+      if (meshHeader.vertexCount > file.Size() / sizeof(Vertex) || meshHeader.indexCount > file.Size() / sizeof(uint32_t))
+         return false;
+      mesh.vertices.resize(meshHeader.vertexCount);
+      mesh.indices.resize(meshHeader.indexCount);
+      if (!reader.Read(mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex)) ||
+         !reader.Read(mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t)))
+         return false;
+   }
+   if (!reader.AtEnd()) return false;
+
+   meshes = std::move(loaded);
+   return true;
+}
+
+//       finalPath:         
+//          
+inline string UniqueTempPath(const string& finalPath) {
+   static std::atomic<uint64_t> counter{ 0 };
+   size_t thread = std::hash<std::thread::id>()(std::this_thread::get_id());
+   return finalPath + "." + std::to_string(thread) + "." + std::to_string(++counter) + ".tmp";
+}
+
+//       finalPath. rename    
+// ( Windows -  MoveFileEx  );    ,     ,
+//    -   
+inline bool ReplaceCacheFile(const string& tempPath, const string& finalPath) {
+   std::error_code ec;
+   std::filesystem::rename(tempPath, finalPath, ec);
+   if (!ec) return true;
+   std::filesystem::remove(tempPath, ec);
+   return false;
+}
+
+//        ,      
+inline bool WriteMeshCache(const MeshCacheKey& key, const vector<MeshData>& meshes) {
+   static_assert(sizeof(unsigned int) == sizeof(uint32_t), "mesh cache stores 32-bit indices");
+   static_assert(sizeof(Vertex) % 4 == 0, "mesh cache expects 4-byte aligned vertices");
+
+   std::error_code ec;
+   std::filesystem::create_directories(MESH_CACHE_DIRECTORY, ec);
+   string finalPath = MeshCacheFilePath(key);
+   string tempPath = UniqueTempPath(finalPath);
+
+   {
+      std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+      if (!out) {
+         LOG_WARN("Mesh cache: cannot write %s", tempPath.c_str());
+         return false;
+      }
+
+      const char padding[4] = { 0, 0, 0, 0 };
+      auto pad4 = [&](size_t written) { out.write(padding, (4 - written % 4) % 4); };
+
+      MeshCacheHeader header = {};
+      header.magic = MESH_CACHE_MAGIC;
+      header.version = MESH_CACHE_VERSION;
+      header.vertexSize = sizeof(Vertex);
+      header.importFlags = key.importFlags;
+      header.sourceSize = key.sourceSize;
+      header.sourceTime = key.sourceTime;
+      header.meshCount = static_cast<uint32_t>(meshes.size());
+      header.pathLength = static_cast<uint32_t>(key.sourcePath.size());
+      header.dependencyCount = static_cast<uint32_t>(key.dependencies.size());
+      out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      out.write(key.sourcePath.data(), key.sourcePath.size());
+      pad4(key.sourcePath.size());
+
+      for (const MeshCacheDependency& dependency : key.dependencies) {
+         MeshCacheDependencyHeader dependencyHeader = {};
+         dependencyHeader.size = dependency.size;
+         dependencyHeader.time = dependency.time;
+         dependencyHeader.pathLength = static_cast<uint32_t>(dependency.path.size());
+         out.write(reinterpret_cast<const char*>(&dependencyHeader), sizeof(dependencyHeader));
+         out.write(dependency.path.data(), dependency.path.size());
+         pad4(dependency.path.size());
+      }
+
+      for (const MeshData& mesh : meshes) {
+         MeshCacheMeshHeader meshHeader = {};
+         meshHeader.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+         meshHeader.indexCount = static_cast<uint32_t>(mesh.indices.size());
+         meshHeader.textureCount = static_cast<uint32_t>(mesh.textures.size());
+         out.write(reinterpret_cast<const char*>(&meshHeader), sizeof(meshHeader));
+
+         for (const MeshTextureRef& texture : mesh.textures) {
+            uint32_t lengths[2] = { static_cast<uint32_t>(texture.type.size()), static_cast<uint32_t>(texture.path.size()) };
+            out.write(reinterpret_cast<const char*>(lengths), sizeof(lengths));
+            out.write(texture.type.data(), texture.type.size());
+            out.write(texture.path.data(), texture.path.size());
+            pad4(texture.type.size() + texture.path.size());
+         }
+
+         out.write(reinterpret_cast<const char*>(mesh.vertices.data()), mesh.vertices.size() * sizeof(Vertex));
+         out.write(reinterpret_cast<const char*>(mesh.indices.data()), mesh.indices.size() * sizeof(uint32_t));
+      }
+
+      if (!out) {
+         LOG_WARN("Mesh cache: write failed for %s", tempPath.c_str());
+         out.close();
+         std::filesystem::remove(tempPath, ec);
+         return false;
+      }
+   }
+
+   return ReplaceCacheFile(tempPath, finalPath);
+}
+
+#endif
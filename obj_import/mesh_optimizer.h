@@ -0,0 +1,406 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <glm/glm.hpp>
+
+#include "mesh_cache.h"
+#include "tangent_space.h"
+#include "job_system.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+//    ,     :
+// 0)   ,   ,    (Assimp  JoinIdenticalVertices 
+//        )        (tangent_space.h);
+// 1)        ( , LRU-);
+// 2)  -      ,    ;
+// 3)       (    VBO).
+//    ACMR (   )  ATVR (  , 1.0 - )
+
+const uint32_t MESH_OPT_CACHE_SIZE = 32;    //  LRU-   
+const uint32_t MESH_OPT_FIFO_SIZE = 16;     // FIFO-   ACMR/ATVR,    GPU
+const bool MESH_OPT_OVERDRAW = true;        //       
+
+//   .        MESH_CACHE_VERSION
+enum WeldMode { WELD_NONE, WELD_EXACT, WELD_EPSILON };
+const WeldMode MESH_WELD_MODE = WELD_EXACT;
+const float MESH_WELD_EPSILON = 1e-5f;         //       WELD_EPSILON
+const float MESH_WELD_NORMAL_COS = 0.9999f;    //     ( )  WELD_EPSILON
+
+struct VertexCacheStats {
+   float acmr = 0.0f;
+   float atvr = 0.0f;
+};
+
+struct MeshOptimizeStats {
+   VertexCacheStats before;
+   VertexCacheStats after;
+   size_t verticesBefore = 0;
+   size_t verticesAfter = 0;
+};
+
+//  FIFO-     
+inline VertexCacheStats AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, uint32_t cacheSize = MESH_OPT_FIFO_SIZE)
+{
+   VertexCacheStats stats;
+   if (indices.size() < 3 || vertexCount == 0) return stats;
+
+   //   ,       cacheSize 
+   std::vector<uint32_t> stamp(vertexCount, 0);
+   uint32_t misses = 0;
+   for (unsigned int index : indices) {
+      if (stamp[index] == 0 || misses - stamp[index] >= cacheSize) {
+         misses++;
+         stamp[index] = misses;
+      }
+   }
+   stats.acmr = float(misses) / float(indices.size() / 3);
+   stats.atvr = float(misses) / float(vertexCount);
+   return stats;
+}
+
+namespace meshopt_detail {
+
+   //   :         
+   struct ForsythScores {
+      float cache[MESH_OPT_CACHE_SIZE];
+      float valence[MESH_OPT_CACHE_SIZE];
+
+      ForsythScores() {
+         for (uint32_t i = 0; i < MESH_OPT_CACHE_SIZE; ++i) {
+            //        ,    
+            cache[i] = i < 3 ? 0.75f : std::pow(1.0f - float(i - 3) / float(MESH_OPT_CACHE_SIZE - 3), 1.5f);
+            valence[i] = i == 0 ? 0.0f : 2.0f / std::sqrt(float(i));
+         }
+      }
+
+      float Score(int cachePosition, uint32_t remaining) const {
+         if (remaining == 0) return -1.0f;
+         float score = cachePosition >= 0 ? cache[cachePosition] : 0.0f;
+         return score + valence[std::min(remaining, MESH_OPT_CACHE_SIZE - 1)];
+      }
+   };
+
+   inline uint32_t HashWords(const uint32_t* words, size_t count) {
+      uint32_t hash = 2166136261u;
+      for (size_t i = 0; i < count; ++i)
+         hash = (hash ^ words[i]) * 16777619u;
+      return hash ^ (hash >> 15);
+   }
+
+   //   ,    :      UV
+   inline bool SameVertex(const Vertex& a, const Vertex& b, WeldMode mode, float epsilon) {
+      if (mode == WELD_EXACT) return memcmp(&a, &b, sizeof(Vertex)) == 0;
+      glm::vec3 dp = glm::abs(a.Position - b.Position);
+      glm::vec2 dt = glm::abs(a.TexCoords - b.TexCoords);
+      return std::max(dp.x, std::max(dp.y, dp.z)) <= epsilon && std::max(dt.x, dt.y) <= epsilon &&
+         glm::dot(a.Normal, b.Normal) >= MESH_WELD_NORMAL_COS * glm::length(a.Normal) * glm::length(b.Normal) &&
+         glm::dot(a.Tangent, b.Tangent) >= MESH_WELD_NORMAL_COS * glm::length(a.Tangent) * glm::length(b.Tangent) &&
+         glm::dot(a.Bitangent, b.Bitangent) >= MESH_WELD_NORMAL_COS * glm::length(a.Bitangent) * glm::length(b.Bitangent);
+   }
+
+   inline const ForsythScores& Scores() {
+      static const ForsythScores scores;
+      return scores;
+   }
+
+   //  - ,   ,       .
+   // ,     ,     
+   inline void OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices)
+   {
+      size_t triangleCount = indices.size() / 3;
+      std::vector<size_t> clusters;
+      std::vector<uint32_t> stamp(vertices.size(), 0);
+      uint32_t misses = 0;
+      for (size_t t = 0; t < triangleCount; ++t) {
+         int triangleMisses = 0;
+         for (int j = 0; j < 3; ++j) {
+            unsigned int index = indices[t * 3 + j];
+            if (stamp[index] == 0 || misses - stamp[index] >= MESH_OPT_FIFO_SIZE) {
+               misses++;
+               stamp[index] = misses;
+               triangleMisses++;
+            }
+         }
+         if (t == 0 || triangleMisses == 3) clusters.push_back(t);
+      }
+      if (clusters.size() < 2) return;
+      clusters.push_back(triangleCount);
+
+      glm::dvec3 meshCenter(0.0);
+      double meshArea = 0.0;
+      std::vector<glm::vec3> clusterCenters(clusters.size() - 1), clusterNormals(clusters.size() - 1);
+      for (size_t c = 0; c + 1 < clusters.size(); ++c) {
+         glm::vec3 center(0.0f), normal(0.0f);
+         float area = 0.0f;
+         for (size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+            const glm::vec3& v0 = vertices[indices[t * 3]].Position;
+            const glm::vec3& v1 = vertices[indices[t * 3 + 1]].Position;
+            const glm::vec3& v2 = vertices[indices[t * 3 + 2]].Position;
+            glm::vec3 weighted = glm::cross(v1 - v0, v2 - v0);
+            float triangleArea = glm::length(weighted);
+            center += (v0 + v1 + v2) * (triangleArea / 3.0f);
+            normal += weighted;
+            area += triangleArea;
+         }
+         meshCenter += glm::dvec3(center);
+         meshArea += area;
+         clusterCenters[c] = area > 0.0f ? center / area : vertices[indices[clusters[c] * 3]].Position;
+         float length = glm::length(normal);
+         clusterNormals[c] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+      }
+      glm::vec3 center = meshArea > 0.0 ? glm::vec3(meshCenter / meshArea) : glm::vec3(0.0f);
+
+      std::vector<float> keys(clusterCenters.size());
+      std::vector<uint32_t> order(clusterCenters.size());
+      for (size_t c = 0; c < keys.size(); ++c) {
+         keys[c] = glm::dot(clusterCenters[c] - center, clusterNormals[c]);
+         order[c] = static_cast<uint32_t>(c);
+      }
+      std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return keys[a] > keys[b]; });
+
+      std::vector<unsigned int> sorted;
+      sorted.reserve(indices.size());
+      for (uint32_t c : order)
+         sorted.insert(sorted.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+      indices.swap(sorted);
+   }
+
+}
+
+//      (, "Linear-Speed Vertex Cache Optimisation")
+inline void OptimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount)
+{
+   const meshopt_detail::ForsythScores& scores = meshopt_detail::Scores();
+   size_t triangleCount = indices.size() / 3;
+   if (triangleCount < 2) return;
+
+   //    ;      
+   std::vector<uint32_t> remaining(vertexCount, 0);
+   for (size_t i = 0; i < triangleCount * 3; ++i) remaining[indices[i]]++;
+   std::vector<uint32_t> offsets(vertexCount + 1, 0);
+   for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] = offsets[v] + remaining[v];
+   std::vector<uint32_t> adjacency(offsets[vertexCount]);
+   {
+      std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+      for (size_t t = 0; t < triangleCount; ++t)
+         for (int j = 0; j < 3; ++j)
+            adjacency[fill[indices[t * 3 + j]]++] = static_cast<uint32_t>(t);
+   }
+
+   std::vector<float> vertexScore(vertexCount);
+   for (size_t v = 0; v < vertexCount; ++v) vertexScore[v] = scores.Score(-1, remaining[v]);
+   std::vector<float> triangleScore(triangleCount);
+   for (size_t t = 0; t < triangleCount; ++t)
+      triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+   std::vector<bool> emitted(triangleCount, false);
+
+   std::vector<unsigned int> result;
+   result.reserve(triangleCount * 3);
+   std::vector<unsigned int> cache, nextCache;
+   cache.reserve(MESH_OPT_CACHE_SIZE + 3);
+   nextCache.reserve(MESH_OPT_CACHE_SIZE + 3);
+
+   size_t scanCursor = 0;
+   int64_t best = -1;
+   while (result.size() < triangleCount * 3) {
+      //        -    
+      if (best < 0) {
+         while (emitted[scanCursor]) scanCursor++;
+         best = static_cast<int64_t>(scanCursor);
+      }
+
+      size_t triangle = static_cast<size_t>(best);
+      emitted[triangle] = true;
+      nextCache.clear();
+      for (int j = 0; j < 3; ++j) {
+         unsigned int v = indices[triangle * 3 + j];
+         result.push_back(v);
+         nextCache.push_back(v);
+
+         uint32_t* list = adjacency.data() + offsets[v];
+         uint32_t count = remaining[v];
+         for (uint32_t k = 0; k < count; ++k)
+            if (list[k] == triangle) {
+               list[k] = list[count - 1];
+               break;
+            }
+         remaining[v]--;
+      }
+      for (unsigned int v : cache)
+         if (v != nextCache[0] && v != nextCache[1] && v != nextCache[2]) nextCache.push_back(v);
+
+      //       
+      for (size_t i = MESH_OPT_CACHE_SIZE; i < nextCache.size(); ++i) {
+         unsigned int v = nextCache[i];
+         float score = scores.Score(-1, remaining[v]);
+         for (uint32_t k = 0; k < remaining[v]; ++k)
+            triangleScore[adjacency[offsets[v] + k]] += score - vertexScore[v];
+         vertexScore[v] = score;
+      }
+      nextCache.resize(std::min<size_t>(nextCache.size(), MESH_OPT_CACHE_SIZE));
+
+      best = -1;
+      float bestScore = -1.0f;
+      for (size_t i = 0; i < nextCache.size(); ++i) {
+         unsigned int v = nextCache[i];
+         float score = scores.Score(static_cast<int>(i), remaining[v]);
+         float delta = score - vertexScore[v];
+         vertexScore[v] = score;
+         for (uint32_t k = 0; k < remaining[v]; ++k) {
+            uint32_t t = adjacency[offsets[v] + k];
+            triangleScore[t] += delta;
+         }
+      }
+      //  -     
+      for (unsigned int v : nextCache)
+         for (uint32_t k = 0; k < remaining[v]; ++k) {
+            uint32_t t = adjacency[offsets[v] + k];
+            if (triangleScore[t] > bestScore) {
+               bestScore = triangleScore[t];
+               best = t;
+            }
+         }
+      cache.swap(nextCache);
+   }
+   indices.swap(result);
+}
+
+//     ;   
+inline void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+   const unsigned int unused = ~0u;
+   std::vector<unsigned int> remap(vertices.size(), unused);
+   std::vector<Vertex> ordered;
+   ordered.reserve(vertices.size());
+   for (unsigned int& index : indices) {
+      if (remap[index] == unused) {
+         remap[index] = static_cast<unsigned int>(ordered.size());
+         ordered.push_back(vertices[index]);
+      }
+      index = remap[index];
+   }
+   vertices.swap(ordered);
+}
+
+//     -. WELD_EXACT   .
+// WELD_EPSILON     2 * epsilon:    epsilon 
+//    8  (   ),     .
+//    ,    
+inline void WeldVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, WeldMode mode = MESH_WELD_MODE,
+   float epsilon = MESH_WELD_EPSILON)
+{
+   if (mode == WELD_NONE || vertices.empty()) return;
+   static_assert(sizeof(Vertex) % sizeof(uint32_t) == 0, "Vertex must consist of 32-bit words");
+
+   size_t capacity = 16;
+   while (capacity < vertices.size() * 2) capacity <<= 1;
+   const uint32_t empty = ~0u;
+   std::vector<uint32_t> table(capacity, empty);
+   std::vector<glm::ivec3> cells;
+   float cellSize = 2.0f * epsilon;
+
+   std::vector<unsigned int> remap(vertices.size());
+   std::vector<Vertex> welded;
+   welded.reserve(vertices.size());
+   for (size_t v = 0; v < vertices.size(); ++v) {
+      const Vertex& vertex = vertices[v];
+      uint32_t found = empty;
+
+      if (mode == WELD_EXACT) {
+         uint32_t slot = meshopt_detail::HashWords(reinterpret_cast<const uint32_t*>(&vertex), sizeof(Vertex) / sizeof(uint32_t)) & (capacity - 1);
+         for (; table[slot] != empty; slot = (slot + 1) & (capacity - 1))
+            if (meshopt_detail::SameVertex(welded[table[slot]], vertex, mode, epsilon)) {
+               found = table[slot];
+               break;
+            }
+         if (found == empty) {
+            found = static_cast<uint32_t>(welded.size());
+            table[slot] = found;
+            welded.push_back(vertex);
+         }
+      }
+      else {
+         glm::vec3 scaled = vertex.Position / cellSize;
+         glm::ivec3 cell = glm::ivec3(glm::floor(scaled));
+         glm::ivec3 side = glm::ivec3(glm::lessThan(scaled - glm::floor(scaled), glm::vec3(0.5f))) * -2 + 1;
+         for (int n = 0; n < 8 && found == empty; ++n) {
+            glm::ivec3 probe = cell + glm::ivec3(n & 1, (n >> 1) & 1, (n >> 2) & 1) * side;
+            uint32_t slot = meshopt_detail::HashWords(reinterpret_cast<const uint32_t*>(&probe), 3) & (capacity - 1);
+            for (; table[slot] != empty; slot = (slot + 1) & (capacity - 1))
+               if (cells[table[slot]] == probe && meshopt_detail::SameVertex(welded[table[slot]], vertex, mode, epsilon)) {
+                  found = table[slot];
+                  break;
+               }
+         }
+         if (found == empty) {
+            found = static_cast<uint32_t>(welded.size());
+            uint32_t slot = meshopt_detail::HashWords(reinterpret_cast<const uint32_t*>(&cell), 3) & (capacity - 1);
+            while (table[slot] != empty) slot = (slot + 1) & (capacity - 1);
+            table[slot] = found;
+            cells.push_back(cell);
+            welded.push_back(vertex);
+         }
+      }
+      remap[v] = found;
+   }
+
+   if (welded.size() == vertices.size()) return;
+   for (unsigned int& index : indices) index = remap[index];
+   vertices.swap(welded);
+}
+
+//     .  :     (    ),
+//  -  (   );    ,   
+inline MeshOptimizeStats OptimizeMesh(MeshData& mesh, bool optimizeOverdraw = MESH_OPT_OVERDRAW)
+{
+   MeshOptimizeStats stats;
+   stats.verticesBefore = mesh.vertices.size();
+   stats.before = AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+   if (MeshNeedsNormals(mesh))
+      GenerateSmoothNormals(mesh);
+   WeldVertices(mesh.vertices, mesh.indices);
+   if (MeshHasNormalMap(mesh))
+      GenerateTangents(mesh);
+   OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+   if (optimizeOverdraw)
+      meshopt_detail::OptimizeOverdraw(mesh.indices, mesh.vertices);
+   OptimizeVertexFetch(mesh.vertices, mesh.indices);
+   stats.after = AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+   stats.verticesAfter = mesh.vertices.size();
+   return stats;
+}
+
+//     ;    ACMR/ATVR      
+inline void OptimizeMeshes(std::vector<MeshData>& meshes, const std::string& name, bool optimizeOverdraw = MESH_OPT_OVERDRAW)
+{
+   std::vector<MeshOptimizeStats> stats(meshes.size());
+   GlobalJobSystem().ParallelFor(static_cast<uint32_t>(meshes.size()), [&](uint32_t i, unsigned) {
+      stats[i] = OptimizeMesh(meshes[i], optimizeOverdraw);
+   });
+
+   double trianglesTotal = 0.0, missesBefore = 0.0, missesAfter = 0.0;
+   size_t verticesBefore = 0, verticesAfter = 0;
+   for (size_t i = 0; i < meshes.size(); ++i) {
+      double triangles = double(meshes[i].indices.size() / 3);
+      LOG_DEBUG("Mesh optimizer: %s #%zu (%zu triangles): vertices %zu -> %zu, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f", name.c_str(), i,
+         meshes[i].indices.size() / 3, stats[i].verticesBefore, stats[i].verticesAfter,
+         stats[i].before.acmr, stats[i].after.acmr, stats[i].before.atvr, stats[i].after.atvr);
+      verticesBefore += stats[i].verticesBefore;
+      verticesAfter += stats[i].verticesAfter;
+      trianglesTotal += triangles;
+      missesBefore += stats[i].before.acmr * triangles;
+      missesAfter += stats[i].after.acmr * triangles;
+   }
+   if (trianglesTotal > 0.0)
+      LOG_INFO("Mesh optimizer: %s: vertices %zu -> %zu, ACMR %.3f -> %.3f over %zu meshes", name.c_str(),
+         verticesBefore, verticesAfter, missesBefore / trianglesTotal, missesAfter / trianglesTotal, meshes.size());
+}
+
+#endif
@@ -12,30 +12,62 @@
 
 #include "mesh.h"
 #include "shader.h"
-
+#include "bvh.h"
+#include "mesh_cache.h"
+#include "texture_cache.h"
+#include "obj_parser.h"
+#include "mesh_optimizer.h"
+#include "job_system.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <unordered_map>
+#include <memory>
 #include <vector>
 using namespace std;
 
 unsigned int TextureFromFile(const char* path, const string& directory, bool gamma = false);
 
+//   ,      
+const uint32_t MODEL_VERTEX_BLOCK = 16384;
+
+//     ,   .
+//         
+struct NormalLineBuffers {
+   GLuint faceVAO = 0, faceVBO = 0;
+   GLuint vertexVAO = 0, vertexVBO = 0;
+   GLsizei faceLineVertices = 0;
+   GLsizei vertexLineVertices = 0;
+   bool built = false;
+};
+
 class Model
 {
 public:
    //   
    vector<Texture> textures_loaded; // ()    ,  ,       
    vector<Mesh> meshes;
+   std::shared_ptr<const BVH> bvh; //     ;     
    string directory;
    bool gammaCorrection;
    bool useOriginalTextures = true;
+   VertexFormat vertexFormat = VERTEX_FORMAT_FLOAT; //    GPU    
+   GeometryResidency geometryResidency = GEOMETRY_RESIDENCY_POSITIONS; //     CPU   
+   std::shared_ptr<NormalLineBuffers> normalLines = std::make_shared<NormalLineBuffers>();
+   unordered_map<string, TextureHandle> textureHandles; //          ;    
 
    Model() : gammaCorrection(false), useOriginalTextures(true) {}
    //        3D-
-   Model(string const& path, bool gamma = false) : gammaCorrection(gamma)
+   Model(string const& path, bool gamma = false, VertexFormat format = VERTEX_FORMAT_FLOAT,
+      GeometryResidency residency = GEOMETRY_RESIDENCY_POSITIONS) : gammaCorrection(gamma), vertexFormat(format), geometryResidency(residency)
    {
       loadModel(path);
    }
@@ -47,142 +79,402 @@ public:
       }
    }
 
+   //  count   -     .     instanceBuffer,   first
+   void DrawInstanced(const Shader& shader, GLuint instanceBuffer, GLsizei first, GLsizei count, int reservedTextureUnit = -1) const {
+      for (const Mesh& mesh : meshes)
+         mesh.DrawInstanced(shader, useOriginalTextures, instanceBuffer, first, count, reservedTextureUnit);
+   }
+
+   //    (faceNormals)    GL_LINES.    
+   void DrawNormals(bool faceNormals) const {
+      if (!normalLines->built) BuildNormalLines();
+      glBindVertexArray(faceNormals ? normalLines->faceVAO : normalLines->vertexVAO);
+      glDrawArrays(GL_LINES, 0, faceNormals ? normalLines->faceLineVertices : normalLines->vertexLineVertices);
+      glBindVertexArray(0);
+   }
+
    void setUseOriginalTextures(bool use) {
       useOriginalTextures = use;
    }
 
-   glm::vec3 GetBoundingSphere() const {
-      glm::vec3 minBounds(std::numeric_limits<float>::max());
-      glm::vec3 maxBounds(std::numeric_limits<float>::lowest());
+   //  BVH   .     meshes,     
+   void BuildBVH() {
+      auto built = std::make_shared<BVH>();
+      built->Build(meshes);
+      bvh = built;
+   }
+
+   //     .     ComputeBounds
+   const AABB& GetBounds() const { return bounds; }
+   const BoundingSphere& GetBoundingSphere() const { return boundingSphere; }
+
+   //    : AABB       ,  -    .
+   //     meshes,     
+   void ComputeBounds() {
+      ComputeBounds(meshes, bounds, boundingSphere);
+   }
+
+   //         vertices (Mesh  MeshData) -     
+   template <typename MeshList>
+   static void ComputeBounds(const MeshList& meshList, AABB& outBounds, BoundingSphere& outSphere) {
+      outBounds = AABB();
+      for (const auto& mesh : meshList)
+         for (const auto& vertex : mesh.vertices)
+            outBounds.Grow(vertex.Position);
+
+      outSphere = BoundingSphere();
+      if (!outBounds.Valid()) return;
+      outSphere.center = outBounds.Center();
+      float radius2 = 0.0f;
+      for (const auto& mesh : meshList)
+         for (const auto& vertex : mesh.vertices)
+            radius2 = std::max(radius2, glm::dot(vertex.Position - outSphere.center, vertex.Position - outSphere.center));
+      outSphere.radius = std::sqrt(radius2);
+   }
+
+   //     :    textures_loaded  ,    GPU
+   //   vertexFormat,   CPU-   geometryResidency.
+   // directory, BVH      
+   void AppendMesh(MeshData&& data) {
+      vector<Texture> textures;
+      for (const MeshTextureRef& ref : data.textures)
+         textures.push_back(loadTexture(ref));
+      meshes.emplace_back(std::move(data.vertices), std::move(data.indices), std::move(textures), vertexFormat);
+      meshes.back().ReleaseGeometry(geometryResidency);
+   }
+
+   //     (AssetLoader): BVH      
+   void FinishLoad(std::shared_ptr<const BVH> builtBVH, const AABB& modelBounds, const BoundingSphere& modelSphere) {
+      bvh = std::move(builtBVH);
+      bounds = modelBounds;
+      boundingSphere = modelSphere;
+   }
+
+   //  CPU-     
+   size_t GeometryBytes() const {
+      size_t bytes = 0;
+      for (const Mesh& mesh : meshes) bytes += mesh.GeometryBytes();
+      return bytes;
+   }
+
+   //  GL-    .    GL-
+   void ReleaseGL() {
+      for (Mesh& mesh : meshes)
+         mesh.ReleaseGL();
+      NormalLineBuffers& lines = *normalLines;
+      if (lines.built) {
+         glDeleteVertexArrays(1, &lines.faceVAO);
+         glDeleteBuffers(1, &lines.faceVBO);
+         glDeleteVertexArrays(1, &lines.vertexVAO);
+         glDeleteBuffers(1, &lines.vertexVBO);
+      }
+      lines = NormalLineBuffers();
+   }
+private:
+   AABB bounds;
+   BoundingSphere boundingSphere;
+
+   void BuildNormalLines() const {
+      vector<glm::vec3> faceLines;
+      vector<glm::vec3> vertexLines;
+      size_t indexCount = 0;
+      for (const auto& mesh : meshes) indexCount += mesh.indices.size();
+      faceLines.reserve(indexCount / 3 * 2);
+      vertexLines.reserve(indexCount * 2);
 
-      //   
       for (const auto& mesh : meshes) {
-         for (const auto& vertex : mesh.vertices) {
-            minBounds = glm::min(minBounds, vertex.Position);
-            maxBounds = glm::max(maxBounds, vertex.Position);
+         //     CPU- (  );    ,
+         //       
+         const bool full = !mesh.vertices.empty();
+         const bool storedNormals = full || mesh.normals.size() == mesh.positions.size();
+         auto position = [&](unsigned int index) { return full ? mesh.vertices[index].Position : mesh.positions[index]; };
+         vector<glm::vec3> smoothNormals;
+         if (!storedNormals) {
+            smoothNormals.assign(mesh.positions.size(), glm::vec3(0.0f));
+            for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+               glm::vec3 v0 = position(mesh.indices[i]);
+               glm::vec3 area = glm::cross(position(mesh.indices[i + 1]) - v0, position(mesh.indices[i + 2]) - v0);
+               for (int j = 0; j < 3; ++j) smoothNormals[mesh.indices[i + j]] += area;
+            }
+            for (glm::vec3& normal : smoothNormals) {
+               float length = glm::length(normal);
+               normal = length > 0.0f ? normal / length : glm::vec3(0.0f);
+            }
+         }
+
+         for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+            glm::vec3 v0 = position(mesh.indices[i]);
+            glm::vec3 v1 = position(mesh.indices[i + 1]);
+            glm::vec3 v2 = position(mesh.indices[i + 2]);
+            glm::vec3 center = (v0 + v1 + v2) / 3.0f;
+            glm::vec3 normal = glm::normalize(glm::cross(v1 - v0, v2 - v0));
+            faceLines.push_back(center);
+            faceLines.push_back(center + normal * 0.8f);
+
+            for (int j = 0; j < 3; ++j) {
+               unsigned int index = mesh.indices[i + j];
+               glm::vec3 vertexNormal = full ? mesh.vertices[index].Normal : storedNormals ? mesh.normals[index] : smoothNormals[index];
+               vertexLines.push_back(position(index));
+               vertexLines.push_back(position(index) + vertexNormal * 0.5f);
+            }
          }
       }
 
-      //     
-      glm::vec3 diagonal = maxBounds - minBounds;
-      float radius = glm::length(diagonal) * 0.5f;
+      NormalLineBuffers& lines = *normalLines;
+      UploadLines(faceLines, lines.faceVAO, lines.faceVBO);
+      UploadLines(vertexLines, lines.vertexVAO, lines.vertexVBO);
+      lines.faceLineVertices = static_cast<GLsizei>(faceLines.size());
+      lines.vertexLineVertices = static_cast<GLsizei>(vertexLines.size());
+      lines.built = true;
+   }
 
-      //  ,  x,y,z -  ,    - 
-      return (maxBounds + minBounds) * 0.5f + glm::vec3(radius);
+   static void UploadLines(const vector<glm::vec3>& points, GLuint& vao, GLuint& vbo) {
+      glGenVertexArrays(1, &vao);
+      glGenBuffers(1, &vbo);
+      glBindVertexArray(vao);
+      glBindBuffer(GL_ARRAY_BUFFER, vbo);
+      glBufferData(GL_ARRAY_BUFFER, points.size() * sizeof(glm::vec3), points.data(), GL_STATIC_DRAW);
+      glEnableVertexAttribArray(0);
+      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+      glBindVertexArray(0);
    }
-private:
-   //     Assimp       meshes
+
+   //  :    ,   -   Assimp    
    void loadModel(string const& path)
    {
-      //     Assimp
+      vector<MeshData> meshData;
+      if (!LoadMeshData(path, meshData))
+         return;
+
+      //    
+      directory = path.substr(0, path.find_last_of('/'));
+
+      //  BVH    ,        .
+      //    :  AppendMesh     geometryResidency
+      auto built = std::make_shared<BVH>();
+      built->Build(meshData);
+      bvh = built;
+      ComputeBounds(meshData, bounds, boundingSphere);
+
+      prefetchTextures(meshData);
+      meshes.reserve(meshData.size());
+      for (MeshData& data : meshData)
+         AppendMesh(std::move(data));
+   }
+
+public:
+   //     :     XY
+   static TextureUsage TextureUsageOf(const MeshTextureRef& ref)
+   {
+      return ref.type == "texture_normal" ? TEXTURE_USAGE_NORMAL : TEXTURE_USAGE_COLOR;
+   }
+
+private:
+   //     .      ,     
+   Texture loadTexture(const MeshTextureRef& ref)
+   {
+      auto found = textureHandles.find(ref.path);
+      if (found == textureHandles.end())
+      {
+         found = textureHandles.emplace(ref.path, GlobalTextureCache().Acquire(this->directory + '/' + ref.path, TextureUsageOf(ref))).first;
+
+         Texture texture;
+         texture.id = found->second->id;
+         texture.type = ref.type;
+         texture.path = ref.path;
+         textures_loaded.push_back(texture); //        
+      }
+
+      Texture texture;
+      texture.id = found->second->id;
+      texture.type = ref.type;
+      texture.path = ref.path;
+      return texture;
+   }
+
+   //      :     
+   void prefetchTextures(const vector<MeshData>& meshData)
+   {
+      vector<string> paths;
+      vector<string> refs;
+      vector<TextureUsage> usages;
+      for (const MeshData& data : meshData)
+         for (const MeshTextureRef& ref : data.textures)
+            if (textureHandles.find(ref.path) == textureHandles.end() && std::find(refs.begin(), refs.end(), ref.path) == refs.end()) {
+               refs.push_back(ref.path);
+               paths.push_back(this->directory + '/' + ref.path);
+               usages.push_back(TextureUsageOf(ref));
+            }
+
+      vector<TextureHandle> handles = GlobalTextureCache().AcquireMany(paths, usages);
+      for (size_t i = 0; i < refs.size(); ++i)
+         textureHandles.emplace(refs[i], handles[i]);
+   }
+
+public:
+   //   Assimp;    ,      .
+   //    Assimp  :        OptimizeMeshes
+   static const unsigned int IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_FlipUVs;
+
+   //      OpenGL:  ,   Assimp   .
+   // fromCache ( ) ,   
+   static bool LoadMeshData(string const& path, vector<MeshData>& meshData, bool* fromCache = nullptr)
+   {
+      if (fromCache) *fromCache = false;
+
+      MeshCacheKey key;
+      bool keyValid = MakeMeshCacheKey(path, IMPORT_FLAGS, key);
+      if (keyValid && ReadMeshCache(key, meshData)) {
+         LOG_INFO("Mesh cache hit: %s (%zu meshes)", path.c_str(), meshData.size());
+         if (fromCache) *fromCache = true;
+         return true;
+      }
+
+      vector<string> dependencies;
+      if (!ImportMeshData(path, meshData, true, &dependencies))
+         return false;
+      //        ,    
+      OptimizeMeshes(meshData, path);
+      for (const string& dependency : dependencies)
+         key.dependencies.push_back(MakeMeshCacheDependency(dependency));
+      if (keyValid && !WriteMeshCache(key, meshData))
+         LOG_WARN("Mesh cache: failed to store %s", path.c_str());
+      return true;
+   }
+
+   //     ,     . OBJ  
+   //  (allowNativeObj),    OBJ,    , -  Assimp.
+   // dependencies ( )     -   OBJ
+   static bool ImportMeshData(string const& path, vector<MeshData>& meshData, bool allowNativeObj = true, vector<string>* dependencies = nullptr)
+   {
+      string extension = std::filesystem::path(path).extension().string();
+      std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+      if (allowNativeObj && extension == ".obj") {
+         if (ParseObjFile(path, meshData, dependencies))
+            return true;
+         LOG_WARN("OBJ: falling back to Assimp for %s", path.c_str());
+      }
+
       Assimp::Importer importer;
-      const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals);
+      const aiScene* scene = importer.ReadFile(path, IMPORT_FLAGS);
 
       //   
       if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) //   0
       {
          cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
-         return;
+         return false;
       }
 
-      //    
-      directory = path.substr(0, path.find_last_of('/'));
-
-      //     Assimp
-      processNode(scene->mRootNode, scene);
+      //   Assimp     
+      vector<const aiMesh*> order;
+      processNode(scene->mRootNode, scene, order);
+      processMeshes(order, scene, meshData);
+      return true;
    }
 
-   //   .    ,   ,         (   )
-   void processNode(aiNode* node, const aiScene* scene)
+private:
+   //   .       ,       (   ).
+   //   ,        
+   static void processNode(aiNode* node, const aiScene* scene, vector<const aiMesh*>& order)
    {
-      //     
+      //       .
+      //     ;  -     
       for (unsigned int i = 0; i < node->mNumMeshes; i++)
-      {
-         //       .
-         //     ;  -     
-         aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-         meshes.push_back(processMesh(mesh, scene));
-      }
-      //  ,      (  ),        
+         order.push_back(scene->mMeshes[node->mMeshes[i]]);
+
       for (unsigned int i = 0; i < node->mNumChildren; i++)
-      {
-         processNode(node->mChildren[i], scene);
+         processNode(node->mChildren[i], scene, order);
+   }
+
+   //    .       , 
+   //     MODEL_VERTEX_BLOCK   ,    -    
+   static void processMeshes(const vector<const aiMesh*>& order, const aiScene* scene, vector<MeshData>& meshData)
+   {
+      struct Block {
+         uint32_t mesh, begin, end;
+      };
+      vector<Block> blocks;
+      meshData.assign(order.size(), MeshData());
+      for (uint32_t m = 0; m < order.size(); ++m) {
+         const aiMesh* mesh = order[m];
+         size_t indexCount = 0;
+         for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+            indexCount += mesh->mFaces[i].mNumIndices;
+         meshData[m].vertices.resize(mesh->mNumVertices);
+         meshData[m].indices.resize(indexCount);
+
+         //   begin == 0      
+         uint32_t begin = 0;
+         do {
+            uint32_t end = std::min(mesh->mNumVertices, begin + MODEL_VERTEX_BLOCK);
+            blocks.push_back({ m, begin, end });
+            begin = end;
+         } while (begin < mesh->mNumVertices);
       }
 
+      GlobalJobSystem().ParallelFor(static_cast<uint32_t>(blocks.size()), [&](uint32_t b, unsigned) {
+         const Block& block = blocks[b];
+         convertVertices(order[block.mesh], block.begin, block.end, meshData[block.mesh].vertices.data());
+         if (block.begin == 0)
+            processFaces(order[block.mesh], scene, meshData[block.mesh]);
+      });
    }
 
-   Mesh processMesh(aiMesh* mesh, const aiScene* scene)
+   //   [begin, end)    
+   static void convertVertices(const aiMesh* mesh, uint32_t begin, uint32_t end, Vertex* vertices)
    {
-      //   
-      vector<Vertex> vertices;
-      vector<unsigned int> indices;
-      vector<Texture> textures;
-
-      //     
-      for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+      for (unsigned int i = begin; i < end; i++)
       {
-         Vertex vertex;
-         glm::vec3 vector; //    , .. Assimp     ,       glm::vec3,           glm::vec3
+         Vertex& vertex = vertices[i];
 
+         // Assimp     ,       glm::vec3,   
          // 
-         vector.x = mesh->mVertices[i].x;
-         vector.y = mesh->mVertices[i].y;
-         vector.z = mesh->mVertices[i].z;
-         vertex.Position = vector;
+         vertex.Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
 
          // 
-         vector.x = mesh->mNormals[i].x;
-         vector.y = mesh->mNormals[i].y;
-         vector.z = mesh->mNormals[i].z;
-         vertex.Normal = vector;
+         if (mesh->mNormals)
+            vertex.Normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
+         else
+            vertex.Normal = glm::vec3(0.0f, 0.0f, 0.0f);
 
          //  
+         //     8   .  ,      ,
+         //        ,       (0)
          if (mesh->mTextureCoords[0]) //     
-         {
-            glm::vec2 vec;
-
-            //     8   .  ,      ,
-            //        ,       (0)
-            vec.x = mesh->mTextureCoords[0][i].x;
-            vec.y = mesh->mTextureCoords[0][i].y;
-            vertex.TexCoords = vec;
-         }
+            vertex.TexCoords = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
          else
             vertex.TexCoords = glm::vec2(0.0f, 0.0f);
 
          //  
-         if (mesh->mTangents) {
-            vector.x = mesh->mTangents[i].x;
-            vector.y = mesh->mTangents[i].y;
-            vector.z = mesh->mTangents[i].z;
-            vertex.Tangent = vector;
-         } else {
+         if (mesh->mTangents)
+            vertex.Tangent = glm::vec3(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z);
+         else
             vertex.Tangent = glm::vec3(0.0f, 0.0f, 0.0f); // Default or fallback value
-         }
 
          //  
-         if (mesh->mBitangents) {
-            vector.x = mesh->mBitangents[i].x;
-            vector.y = mesh->mBitangents[i].y;
-            vector.z = mesh->mBitangents[i].z;
-            vertex.Bitangent = vector;
-         } else {
+         if (mesh->mBitangents)
+            vertex.Bitangent = glm::vec3(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z);
+         else
             vertex.Bitangent = glm::vec3(0.0f, 0.0f, 0.0f); // Default or fallback value
-         }
-         vertices.push_back(vertex);
       }
+   }
+
+   static void processFaces(const aiMesh* mesh, const aiScene* scene, MeshData& data)
+   {
       //       ( -   )     
+      unsigned int* indices = data.indices.data();
       for (unsigned int i = 0; i < mesh->mNumFaces; i++)
       {
-         aiFace face = mesh->mFaces[i];
+         const aiFace& face = mesh->mFaces[i];
 
-         //          indices
+         //          indices
          for (unsigned int j = 0; j < face.mNumIndices; j++)
-            indices.push_back(face.mIndices[j]);
+            *indices++ = face.mIndices[j];
       }
 
       //  
       aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+      vector<MeshTextureRef>& textures = data.textures;
 
       //        .      'texture_diffuseN',
       //  N -    1  MAX_SAMPLER_NUMBER. 
@@ -192,99 +484,91 @@ private:
       //  - texture_normalN
 
       // 1.  
-      vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-      textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+      collectMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", textures);
 
       // 2.  
-      vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-      textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+      collectMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular", textures);
 
       // 3.  
-      std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
-      textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+      collectMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal", textures);
 
       // 4.  
-      std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
-      textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
+      collectMaterialTextures(material, aiTextureType_AMBIENT, "texture_height", textures);
 
-      //  -,     
-      return Mesh(vertices, indices, textures);
+      // GL-    loadModel
    }
 
-   //         ,      .
-   //       Texture
-   vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, string typeName)
+   //        .     loadTexture
+   static void collectMaterialTextures(aiMaterial* mat, aiTextureType type, const string& typeName, vector<MeshTextureRef>& textures)
    {
-      vector<Texture> textures;
       for (unsigned int i = 0; i < mat->GetTextureCount(type); i++)
       {
          aiString str;
          mat->GetTexture(type, i, &str);
-
-         // ,      ,   - ,          
-         bool skip = false;
-         for (unsigned int j = 0; j < textures_loaded.size(); j++)
-         {
-            if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-            {
-               textures.push_back(textures_loaded[j]);
-               skip = true; //         ,    ()
-               break;
-            }
-         }
-         if (!skip)
-         {   //      ,   
-            Texture texture;
-            texture.id = TextureFromFile(str.C_Str(), this->directory);
-            texture.type = typeName;
-            texture.path = str.C_Str();
-            textures.push_back(texture);
-            textures_loaded.push_back(texture); //        ,   ,         
-         }
+         textures.push_back({ typeName, str.C_Str() });
       }
-      return textures;
    }
 };
 
 
-unsigned int TextureFromFile(const char* path, const string& directory, bool gamma)
-{
-   string filename = string(path);
-   filename = directory + '/' + filename;
+//    
+struct MeshCachePrewarmStats {
+   uint32_t models = 0;   //   
+   uint32_t cached = 0;   //    
+   uint32_t built = 0;    //  Assimp    
+   uint32_t failed = 0;
+   float seconds = 0.0f;
+};
 
-   unsigned int textureID;
-   glGenTextures(1, &textureID);
+//         ,    Assimp.
+//   OpenGL,         (--prewarm-cache <>)
+inline MeshCachePrewarmStats PrewarmMeshCache(const string& root)
+{
+   auto start = std::chrono::high_resolution_clock::now();
+   MeshCachePrewarmStats stats;
 
-   int width, height, nrComponents;
-   //stbi_set_flip_vertically_on_load(true);
-   unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-   if (data)
+   vector<string> paths;
    {
-      GLenum format;
-      if (nrComponents == 1)
-         format = GL_RED;
-      else if (nrComponents == 3)
-         format = GL_RGB;
-      else if (nrComponents == 4)
-         format = GL_RGBA;
-
-      glBindTexture(GL_TEXTURE_2D, textureID);
-      glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-      glGenerateMipmap(GL_TEXTURE_2D);
-
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-      stbi_image_free(data);
-   }
-   else
-   {
-      std::cout << "Texture failed to load at path: " << path << std::endl;
-      stbi_image_free(data);
+      Assimp::Importer importer;
+      std::error_code ec;
+      for (auto it = std::filesystem::recursive_directory_iterator(root, ec); !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+         if (!it->is_regular_file(ec)) continue;
+         string extension = it->path().extension().string();
+         if (!extension.empty() && importer.IsExtensionSupported(extension))
+            paths.push_back(it->path().generic_string());
+      }
+      if (ec)
+         LOG_WARN("Mesh cache prewarm: cannot scan %s: %s", root.c_str(), ec.message().c_str());
    }
+   stats.models = static_cast<uint32_t>(paths.size());
+
+   std::atomic<uint32_t> cached{ 0 }, built{ 0 }, failed{ 0 };
+   GlobalJobSystem().ParallelFor(stats.models, [&](uint32_t index, unsigned) {
+      vector<MeshData> meshData;
+      bool fromCache = false;
+      if (!Model::LoadMeshData(paths[index], meshData, &fromCache)) failed++;
+      else if (fromCache) cached++;
+      else built++;
+   });
+
+   stats.cached = cached.load();
+   stats.built = built.load();
+   stats.failed = failed.load();
+   stats.seconds = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start).count();
+   LOG_INFO("Mesh cache prewarm %s: %u models, %u up to date, %u built, %u failed, %.2f s",
+      root.c_str(), stats.models, stats.cached, stats.built, stats.failed, stats.seconds);
+   return stats;
+}
+
+unsigned int TextureFromFile(const char* path, const string& directory, bool gamma)
+{
+   string filename = string(path);
+   filename = directory + '/' + filename;
 
+   DecodedImage image;
+   DecodeImage(filename, image);
+   unsigned int textureID = UploadTexture(image);
+   image.Free();
    return textureID;
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,377 @@
+#ifndef OBJ_PARSER_H
+#define OBJ_PARSER_H
+
+#include <glm/glm.hpp>
+
+#include "mesh_cache.h"
+#include "job_system.h"
+#include "log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//   Wavefront OBJ/MTL.           ,
+//      :  v/vt/vn (   
+//   )   .        
+//    (v, vt, vn).    ,    Model::IMPORT_FLAGS:  
+//  V.         (tangent_space.h)
+
+const size_t OBJ_MIN_CHUNK_BYTES = 256 * 1024;
+
+namespace obj_detail {
+
+   //    , 0-based; -1 -   
+   struct Corner {
+      int32_t v, t, n;
+   };
+
+   //      
+   struct FaceRun {
+      string material;
+      bool inherited = true; //       -   
+      vector<Corner> corners; //  3  
+   };
+
+   struct Chunk {
+      const char* begin;
+      const char* end;
+      uint32_t positions = 0, texCoords = 0, normals = 0;
+      uint32_t positionBase = 0, texCoordBase = 0, normalBase = 0;
+      vector<FaceRun> runs;
+      vector<string> materialLibs;
+      bool failed = false;
+   };
+
+   inline bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+   inline const char* SkipSpaces(const char* p, const char* end) {
+      while (p < end && IsSpace(*p)) ++p;
+      return p;
+   }
+
+   inline const char* LineEnd(const char* p, const char* end) {
+      const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+      return newline ? newline : end;
+   }
+
+   inline bool ParseFloat(const char*& p, const char* end, float& value) {
+      p = SkipSpaces(p, end);
+      if (p < end && *p == '+') ++p; // from_chars    
+      auto result = std::from_chars(p, end, value);
+      if (result.ec != std::errc()) return false;
+      p = result.ptr;
+      return true;
+   }
+
+   inline bool ParseInt(const char*& p, const char* end, int32_t& value) {
+      bool negative = false;
+      if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+      if (p >= end || *p < '0' || *p > '9') return false;
+      int64_t result = 0;
+      while (p < end && *p >= '0' && *p <= '9' && result < INT32_MAX)
+         result = result * 10 + (*p++ - '0');
+      value = static_cast<int32_t>(negative ? -result : result);
+      return true;
+   }
+
+   // OBJ   1,       
+   inline int32_t ResolveIndex(int32_t index, uint32_t declared) {
+      return index > 0 ? index - 1 : static_cast<int32_t>(declared) + index;
+   }
+
+   inline string RestOfLine(const char* p, const char* end) {
+      p = SkipSpaces(p, end);
+      while (end > p && IsSpace(end[-1])) --end;
+      return string(p, end);
+   }
+
+   //  :   v/vt/vn
+   inline void CountElements(Chunk& chunk) {
+      for (const char* p = chunk.begin; p < chunk.end;) {
+         const char* end = LineEnd(p, chunk.end);
+         p = SkipSpaces(p, end);
+         if (end - p > 1 && p[0] == 'v') {
+            if (IsSpace(p[1])) chunk.positions++;
+            else if (p[1] == 't' && end - p > 2 && IsSpace(p[2])) chunk.texCoords++;
+            else if (p[1] == 'n' && end - p > 2 && IsSpace(p[2])) chunk.normals++;
+         }
+         p = end + 1;
+      }
+   }
+
+   //  :        ,   
+   inline void ParseChunk(Chunk& chunk, vector<glm::vec3>& positions, vector<glm::vec2>& texCoords, vector<glm::vec3>& normals) {
+      uint32_t position = chunk.positionBase, texCoord = chunk.texCoordBase, normal = chunk.normalBase;
+      chunk.runs.emplace_back();
+      vector<Corner> polygon;
+
+      for (const char* p = chunk.begin; p < chunk.end;) {
+         const char* end = LineEnd(p, chunk.end);
+         p = SkipSpaces(p, end);
+         const char* next = end + 1;
+         if (p >= end || *p == '#') { p = next; continue; }
+
+         if (p[0] == 'v' && end - p > 1 && IsSpace(p[1])) {
+            glm::vec3& v = positions[position++];
+            p += 1;
+            if (!ParseFloat(p, end, v.x) || !ParseFloat(p, end, v.y) || !ParseFloat(p, end, v.z)) chunk.failed = true;
+         }
+         else if (p[0] == 'v' && end - p > 2 && p[1] == 't' && IsSpace(p[2])) {
+            glm::vec2& t = texCoords[texCoord++];
+            p += 2;
+            if (!ParseFloat(p, end, t.x)) chunk.failed = true;
+            if (!ParseFloat(p, end, t.y)) t.y = 0.0f;
+            t.y = 1.0f - t.y; // aiProcess_FlipUVs
+         }
+         else if (p[0] == 'v' && end - p > 2 && p[1] == 'n' && IsSpace(p[2])) {
+            glm::vec3& n = normals[normal++];
+            p += 2;
+            if (!ParseFloat(p, end, n.x) || !ParseFloat(p, end, n.y) || !ParseFloat(p, end, n.z)) chunk.failed = true;
+         }
+         else if (p[0] == 'f' && end - p > 1 && IsSpace(p[1])) {
+            polygon.clear();
+            p = SkipSpaces(p + 1, end);
+            while (p < end) {
+               Corner corner = { -1, -1, -1 };
+               int32_t index;
+               if (!ParseInt(p, end, index)) { chunk.failed = true; break; }
+               corner.v = ResolveIndex(index, position);
+               if (p < end && *p == '/') {
+                  ++p;
+                  if (p < end && *p != '/') {
+                     if (!ParseInt(p, end, index)) { chunk.failed = true; break; }
+                     corner.t = ResolveIndex(index, texCoord);
+                  }
+                  if (p < end && *p == '/') {
+                     ++p;
+                     if (!ParseInt(p, end, index)) { chunk.failed = true; break; }
+                     corner.n = ResolveIndex(index, normal);
+                  }
+               }
+               polygon.push_back(corner);
+               p = SkipSpaces(p, end);
+            }
+
+            vector<Corner>& corners = chunk.runs.back().corners;
+            for (size_t i = 2; i < polygon.size(); ++i) {
+               corners.push_back(polygon[0]);
+               corners.push_back(polygon[i - 1]);
+               corners.push_back(polygon[i]);
+            }
+         }
+         else if (end - p > 6 && strncmp(p, "usemtl", 6) == 0 && IsSpace(p[6])) {
+            if (!chunk.runs.back().corners.empty() || !chunk.runs.back().inherited)
+               chunk.runs.emplace_back();
+            chunk.runs.back().material = RestOfLine(p + 6, end);
+            chunk.runs.back().inherited = false;
+         }
+         else if (end - p > 6 && strncmp(p, "mtllib", 6) == 0 && IsSpace(p[6])) {
+            chunk.materialLibs.push_back(RestOfLine(p + 6, end));
+         }
+         p = next;
+      }
+   }
+
+   //  MTL:        .
+   //    ,   Assimp  OBJ  processFaces: map_Kd, map_Ks, map_bump/bump (HEIGHT), map_Ka (AMBIENT)
+   inline void ParseMaterialLibrary(const string& path, unordered_map<string, vector<MeshTextureRef>>& materials) {
+      MappedFile file;
+      if (!file.Open(path)) {
+         LOG_WARN("OBJ: material library not found: %s", path.c_str());
+         return;
+      }
+
+      const char* p = reinterpret_cast<const char*>(file.Data());
+      const char* fileEnd = p + file.Size();
+      vector<MeshTextureRef>* current = nullptr;
+      while (p < fileEnd) {
+         const char* end = LineEnd(p, fileEnd);
+         const char* line = SkipSpaces(p, end);
+         p = end + 1;
+
+         const char* keyEnd = line;
+         while (keyEnd < end && !IsSpace(*keyEnd)) ++keyEnd;
+         string key(line, keyEnd);
+         if (key == "newmtl") {
+            current = &materials[RestOfLine(keyEnd, end)];
+            continue;
+         }
+         if (!current) continue;
+
+         const char* type = nullptr;
+         if (key == "map_Kd") type = "texture_diffuse";
+         else if (key == "map_Ks") type = "texture_specular";
+         else if (key == "map_bump" || key == "map_Bump" || key == "bump") type = "texture_normal";
+         else if (key == "map_Ka") type = "texture_height";
+         if (!type) continue;
+
+         //   "-bm 1.0 file.png" :   -   
+         string value = RestOfLine(keyEnd, end);
+         size_t lastSpace = value.find_last_of(" \t");
+         if (lastSpace != string::npos && value[0] == '-') value = value.substr(lastSpace + 1);
+         if (!value.empty()) current->push_back({ type, value });
+      }
+   }
+
+   //   -  ;     .
+   // expected -    ;      
+   class CornerTable {
+   public:
+      explicit CornerTable(size_t expected) {
+         size_t capacity = 16;
+         while (capacity < expected * 2) capacity <<= 1;
+         keys.resize(capacity);
+         values.assign(capacity, UINT32_MAX);
+         mask = capacity - 1;
+      }
+
+      //     true,    
+      bool Insert(const Corner& corner, uint32_t candidate, uint32_t& index) {
+         uint64_t hash = (static_cast<uint64_t>(static_cast<uint32_t>(corner.v)) * 0x9E3779B97F4A7C15ull) ^
+            (static_cast<uint64_t>(static_cast<uint32_t>(corner.t)) * 0xC2B2AE3D27D4EB4Full) ^
+            (static_cast<uint64_t>(static_cast<uint32_t>(corner.n)) * 0x165667B19E3779F9ull);
+         for (size_t slot = (hash ^ (hash >> 29)) & mask;; slot = (slot + 1) & mask) {
+            if (values[slot] == UINT32_MAX) {
+               keys[slot] = corner;
+               values[slot] = index = candidate;
+               return true;
+            }
+            if (keys[slot].v == corner.v && keys[slot].t == corner.t && keys[slot].n == corner.n) {
+               index = values[slot];
+               return false;
+            }
+         }
+      }
+
+   private:
+      vector<Corner> keys;
+      vector<uint32_t> values;
+      size_t mask;
+   };
+}
+
+//  OBJ   (   ). false -    ,     Assimp.
+// materialLibraries ( )    MTL -     
+inline bool ParseObjFile(const string& path, vector<MeshData>& meshes, vector<string>* materialLibraries = nullptr) {
+   using namespace obj_detail;
+
+   MappedFile file;
+   if (!file.Open(path)) return false;
+   const char* data = reinterpret_cast<const char*>(file.Data());
+   const char* dataEnd = data + file.Size();
+   JobSystem& jobs = GlobalJobSystem();
+
+   //    
+   size_t chunkCount = std::max<size_t>(1, std::min<size_t>(jobs.ThreadCount() * 4, file.Size() / OBJ_MIN_CHUNK_BYTES));
+   vector<Chunk> chunks(chunkCount);
+   const char* cursor = data;
+   for (size_t i = 0; i < chunkCount; ++i) {
+      const char* end = i + 1 == chunkCount ? dataEnd : std::max(cursor, data + file.Size() * (i + 1) / chunkCount);
+      if (end < dataEnd) end = LineEnd(end, dataEnd) + 1;
+      if (end > dataEnd) end = dataEnd;
+      chunks[i].begin = cursor;
+      chunks[i].end = end;
+      cursor = end;
+   }
+
+   jobs.ParallelFor(static_cast<uint32_t>(chunkCount), [&](uint32_t i, unsigned) { CountElements(chunks[i]); });
+
+   uint32_t positionCount = 0, texCoordCount = 0, normalCount = 0;
+   for (Chunk& chunk : chunks) {
+      chunk.positionBase = positionCount;
+      chunk.texCoordBase = texCoordCount;
+      chunk.normalBase = normalCount;
+      positionCount += chunk.positions;
+      texCoordCount += chunk.texCoords;
+      normalCount += chunk.normals;
+   }
+   vector<glm::vec3> positions(positionCount);
+   vector<glm::vec2> texCoords(texCoordCount);
+   vector<glm::vec3> normals(normalCount);
+
+   jobs.ParallelFor(static_cast<uint32_t>(chunkCount), [&](uint32_t i, unsigned) { ParseChunk(chunks[i], positions, texCoords, normals); });
+
+   //        
+   vector<string> materialNames;
+   vector<vector<const FaceRun*>> materialRuns;
+   unordered_map<string, size_t> materialIndex;
+   vector<string> materialLibs;
+   string currentMaterial;
+   for (Chunk& chunk : chunks) {
+      if (chunk.failed) {
+         LOG_WARN("OBJ: malformed data in %s", path.c_str());
+         return false;
+      }
+      materialLibs.insert(materialLibs.end(), chunk.materialLibs.begin(), chunk.materialLibs.end());
+      for (FaceRun& run : chunk.runs) {
+         if (!run.inherited) currentMaterial = run.material;
+         if (run.corners.empty()) continue;
+         auto found = materialIndex.find(currentMaterial);
+         if (found == materialIndex.end()) {
+            found = materialIndex.emplace(currentMaterial, materialNames.size()).first;
+            materialNames.push_back(currentMaterial);
+            materialRuns.emplace_back();
+         }
+         materialRuns[found->second].push_back(&run);
+      }
+   }
+
+   string directory = path.substr(0, path.find_last_of('/') + 1);
+   unordered_map<string, vector<MeshTextureRef>> materials;
+   for (const string& lib : materialLibs) {
+      ParseMaterialLibrary(directory + lib, materials);
+      if (materialLibraries) materialLibraries->push_back(directory + lib);
+   }
+
+   //     .   vn   
+   meshes.assign(materialNames.size(), MeshData());
+   std::atomic<bool> valid{ true };
+   jobs.ParallelFor(static_cast<uint32_t>(materialNames.size()), [&](uint32_t m, unsigned) {
+      MeshData& mesh = meshes[m];
+      size_t cornerCount = 0;
+      for (const FaceRun* run : materialRuns[m]) cornerCount += run->corners.size();
+
+      //  OBJ    ( vn   )   ,   -   
+      CornerTable table(cornerCount);
+      mesh.indices.reserve(cornerCount);
+      for (const FaceRun* run : materialRuns[m]) {
+         for (const Corner& corner : run->corners) {
+            if (corner.v < 0 || corner.v >= static_cast<int32_t>(positionCount) || corner.t < -1 || corner.t >= static_cast<int32_t>(texCoordCount) ||
+               corner.n < -1 || corner.n >= static_cast<int32_t>(normalCount)) {
+               valid = false;
+               return;
+            }
+            uint32_t index;
+            if (table.Insert(corner, static_cast<uint32_t>(mesh.vertices.size()), index)) {
+               Vertex vertex;
+               vertex.Position = positions[corner.v];
+               vertex.Normal = corner.n >= 0 ? normals[corner.n] : glm::vec3(0.0f);
+               vertex.TexCoords = corner.t >= 0 ? texCoords[corner.t] : glm::vec2(0.0f);
+               vertex.Tangent = glm::vec3(0.0f);
+               vertex.Bitangent = glm::vec3(0.0f);
+               mesh.vertices.push_back(vertex);
+            }
+            mesh.indices.push_back(index);
+         }
+      }
+
+
+      auto found = materials.find(materialNames[m]);
+      if (found != materials.end()) mesh.textures = found->second;
+   });
+
+   if (!valid) {
+      LOG_WARN("OBJ: index out of range in %s", path.c_str());
+      return false;
+   }
+   return true;
+}
+
+#endif
@@ -0,0 +1,309 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <glad.h>
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+const int PROFILER_HISTORY = 240;                    //    
+const int PROFILER_GPU_LATENCY = 3;                  //     GPU-
+const size_t PROFILER_CAPTURE_EVENTS = 100000;       //     
+
+//     PROFILER_HISTORY 
+class RollingStat {
+public:
+   void Add(float value) {
+      samples[next] = value;
+      next = (next + 1) % PROFILER_HISTORY;
+      count = std::min(count + 1, PROFILER_HISTORY);
+      last = value;
+   }
+
+   bool Empty() const { return count == 0; }
+   float Last() const { return last; }
+
+   float Min() const {
+      if (count == 0) return 0.0f;
+      return *std::min_element(samples, samples + count);
+   }
+
+   float Avg() const {
+      if (count == 0) return 0.0f;
+      float sum = 0.0f;
+      for (int i = 0; i < count; ++i) sum += samples[i];
+      return sum / count;
+   }
+
+   float P99() const {
+      if (count == 0) return 0.0f;
+      float sorted[PROFILER_HISTORY];
+      std::copy(samples, samples + count, sorted);
+      int index = std::min(count - 1, static_cast<int>(count * 0.99f));
+      std::nth_element(sorted, sorted + index, sorted + count);
+      return sorted[index];
+   }
+
+private:
+   float samples[PROFILER_HISTORY] = {};
+   int count = 0;
+   int next = 0;
+   float last = 0.0f;
+};
+
+//         Chrome trace (chrome://tracing, Perfetto)
+struct ProfilerEvent {
+   const char* name;
+   double startUs;
+   double durationUs;
+   int depth;
+   bool gpu;
+};
+
+//  :  CPU-   GL_TIME_ELAPSED    .
+//     PROFILER_GPU_LATENCY      ,    .
+//      
+class FrameProfiler {
+public:
+   void BeginFrame() {
+      slot = static_cast<int>(frameIndex % PROFILER_GPU_LATENCY);
+      CollectGpuResults(slot);
+      frameStartUs = NowUs();
+      frameEvents.clear();
+      stack.clear();
+   }
+
+   void EndFrame() {
+      while (!stack.empty()) End();
+      double frameUs = NowUs() - frameStartUs;
+      frameStat.Add(static_cast<float>(frameUs / 1000.0));
+      lastFrameEvents.swap(frameEvents);
+      lastFrameStartUs = frameStartUs;
+      lastFrameUs = frameUs;
+
+      for (const ProfilerEvent& e : lastFrameEvents)
+         AddCaptureEvent(e);
+      AddCaptureEvent({ "Frame", frameStartUs, frameUs, -1, false });
+      frameIndex++;
+   }
+
+   // gpu -     GPU.   ,    
+   void Begin(const char* name, bool gpu = true) {
+      OpenScope scope;
+      scope.name = name;
+      scope.startUs = NowUs();
+      scope.gpuQuery = 0;
+      if (gpu && !gpuActive) {
+         std::vector<PendingQuery>& queries = gpuQueries[slot];
+         if (gpuUsed[slot] == queries.size()) {
+            PendingQuery created;
+            glGenQueries(1, &created.query);
+            queries.push_back(created);
+         }
+         PendingQuery& pending = queries[gpuUsed[slot]++];
+         pending.name = name;
+         pending.cpuStartUs = scope.startUs;
+         glBeginQuery(GL_TIME_ELAPSED, pending.query);
+         scope.gpuQuery = pending.query;
+         gpuActive = true;
+      }
+      stack.push_back(scope);
+   }
+
+   void End() {
+      if (stack.empty()) return;
+      OpenScope scope = stack.back();
+      stack.pop_back();
+      if (scope.gpuQuery) {
+         glEndQuery(GL_TIME_ELAPSED);
+         gpuActive = false;
+      }
+      double durationUs = NowUs() - scope.startUs;
+      frameEvents.push_back({ scope.name, scope.startUs, durationUs, static_cast<int>(stack.size()), false });
+      FindStats(scope.name).cpu.Add(static_cast<float>(durationUs / 1000.0));
+   }
+
+   // ,    (,  )
+   void AddValue(const char* name, float milliseconds) {
+      FindStats(name).cpu.Add(milliseconds);
+   }
+
+   void DrawImGui() {
+      ImGui::Begin("Profiler");
+      ImGui::Text("Frame: %.2f ms (min %.2f / avg %.2f / p99 %.2f)", frameStat.Last(), frameStat.Min(), frameStat.Avg(), frameStat.P99());
+
+      //  :  CPU-  ,   
+      ImDrawList* drawList = ImGui::GetWindowDrawList();
+      ImVec2 origin = ImGui::GetCursorScreenPos();
+      float width = std::max(100.0f, ImGui::GetContentRegionAvail().x);
+      const float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+      int maxDepth = 0;
+      for (const ProfilerEvent& e : lastFrameEvents) {
+         maxDepth = std::max(maxDepth, e.depth);
+         if (lastFrameUs <= 0.0) continue;
+         float x0 = origin.x + static_cast<float>((e.startUs - lastFrameStartUs) / lastFrameUs) * width;
+         float x1 = x0 + std::max(1.0f, static_cast<float>(e.durationUs / lastFrameUs) * width);
+         float y0 = origin.y + e.depth * rowHeight;
+         ImU32 color = ImGui::GetColorU32(ImVec4(0.25f + 0.12f * (ColorIndex(e.name) % 5), 0.45f, 0.75f - 0.1f * (ColorIndex(e.name) % 4), 1.0f));
+         drawList->AddRectFilled(ImVec2(x0, y0), ImVec2(x1, y0 + rowHeight - 1.0f), color);
+         drawList->PushClipRect(ImVec2(x0, y0), ImVec2(x1, y0 + rowHeight), true);
+         drawList->AddText(ImVec2(x0 + 2.0f, y0 + 2.0f), IM_COL32_WHITE, e.name);
+         drawList->PopClipRect();
+      }
+      ImGui::Dummy(ImVec2(width, rowHeight * (maxDepth + 1)));
+
+      if (ImGui::BeginTable("ProfilerStats", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+         ImGui::TableSetupColumn("Pass");
+         ImGui::TableSetupColumn("CPU min");
+         ImGui::TableSetupColumn("CPU avg");
+         ImGui::TableSetupColumn("CPU p99");
+         ImGui::TableSetupColumn("GPU min");
+         ImGui::TableSetupColumn("GPU avg");
+         ImGui::TableSetupColumn("GPU p99");
+         ImGui::TableHeadersRow();
+         for (const ScopeStats& s : stats) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::Text("%s", s.name);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", s.cpu.Min());
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", s.cpu.Avg());
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", s.cpu.P99());
+            if (s.gpu.Empty()) {
+               ImGui::TableNextColumn(); ImGui::TextDisabled("-");
+               ImGui::TableNextColumn(); ImGui::TextDisabled("-");
+               ImGui::TableNextColumn(); ImGui::TextDisabled("-");
+            }
+            else {
+               ImGui::TableNextColumn(); ImGui::Text("%.3f", s.gpu.Min());
+               ImGui::TableNextColumn(); ImGui::Text("%.3f", s.gpu.Avg());
+               ImGui::TableNextColumn(); ImGui::Text("%.3f", s.gpu.P99());
+            }
+         }
+         ImGui::EndTable();
+      }
+
+      static char tracePath[256] = "profile_trace.json";
+      ImGui::InputText("##tracePath", tracePath, sizeof(tracePath));
+      ImGui::SameLine();
+      if (ImGui::Button("Export Chrome trace")) {
+         if (ExportChromeTrace(tracePath))
+            std::cout << "Profiler trace written to " << tracePath << std::endl;
+      }
+      ImGui::End();
+   }
+
+   //  PROFILER_CAPTURE_EVENTS    Trace Event: CPU -  1, GPU -  2.
+   //  GPU   ,      CPU-
+   bool ExportChromeTrace(const std::string& path) const {
+      std::ofstream out(path);
+      if (!out) {
+         std::cout << "ERROR::PROFILER::CANNOT_WRITE " << path << std::endl;
+         return false;
+      }
+      out << "{\"traceEvents\":[\n";
+      out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+      out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+      char line[256];
+      for (const ProfilerEvent& e : capture) {
+         std::snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+            e.name, e.gpu ? "gpu" : "cpu", e.startUs, e.durationUs, e.gpu ? 2 : 1);
+         out << line;
+      }
+      out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+      return static_cast<bool>(out);
+   }
+
+   void Release() {
+      for (int i = 0; i < PROFILER_GPU_LATENCY; ++i) {
+         for (PendingQuery& q : gpuQueries[i])
+            glDeleteQueries(1, &q.query);
+         gpuQueries[i].clear();
+         gpuUsed[i] = 0;
+      }
+   }
+
+private:
+   struct OpenScope {
+      const char* name;
+      double startUs;
+      GLuint gpuQuery;
+   };
+
+   struct PendingQuery {
+      const char* name = nullptr;
+      double cpuStartUs = 0.0;
+      GLuint query = 0;
+   };
+
+   struct ScopeStats {
+      const char* name;
+      RollingStat cpu;
+      RollingStat gpu;
+   };
+
+   std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+   uint64_t frameIndex = 0;
+   int slot = 0;
+   double frameStartUs = 0.0;
+   double lastFrameStartUs = 0.0;
+   double lastFrameUs = 0.0;
+   std::vector<OpenScope> stack;
+   std::vector<ProfilerEvent> frameEvents;
+   std::vector<ProfilerEvent> lastFrameEvents;
+   std::deque<ProfilerEvent> capture;
+   std::vector<ScopeStats> stats;
+   RollingStat frameStat;
+
+   std::vector<PendingQuery> gpuQueries[PROFILER_GPU_LATENCY];
+   size_t gpuUsed[PROFILER_GPU_LATENCY] = {};
+   bool gpuActive = false;
+
+   double NowUs() const {
+      return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+   }
+
+   static unsigned ColorIndex(const char* name) {
+      unsigned hash = 2166136261u;
+      for (const char* c = name; *c; ++c) hash = (hash ^ static_cast<unsigned char>(*c)) * 16777619u;
+      return hash;
+   }
+
+   ScopeStats& FindStats(const char* name) {
+      for (ScopeStats& s : stats)
+         if (s.name == name || std::strcmp(s.name, name) == 0) return s;
+      stats.push_back({ name, RollingStat(), RollingStat() });
+      return stats.back();
+   }
+
+   void AddCaptureEvent(const ProfilerEvent& e) {
+      capture.push_back(e);
+      if (capture.size() > PROFILER_CAPTURE_EVENTS) capture.pop_front();
+   }
+
+   //      PROFILER_GPU_LATENCY  .  
+   void CollectGpuResults(int s) {
+      for (size_t i = 0; i < gpuUsed[s]; ++i) {
+         PendingQuery& q = gpuQueries[s][i];
+         GLint available = 0;
+         glGetQueryObjectiv(q.query, GL_QUERY_RESULT_AVAILABLE, &available);
+         if (!available) continue;
+         GLuint64 elapsedNs = 0;
+         glGetQueryObjectui64v(q.query, GL_QUERY_RESULT, &elapsedNs);
+         double durationUs = elapsedNs / 1000.0;
+         FindStats(q.name).gpu.Add(static_cast<float>(durationUs / 1000.0));
+         AddCaptureEvent({ q.name, q.cpuStartUs, durationUs, 0, true });
+      }
+      gpuUsed[s] = 0;
+   }
+};
+
+#endif
@@ -1,20 +1,127 @@
+#pragma once
 #include <string>
+#include <vector>
+#include <cmath>
 #include "model.h"
+#include "asset_loader.h"
+#include "asset_registry.h"
+#include "bvh.h"
 
 //       
 struct SceneObject {
    std::string name;
-   Model model;
+   ModelHandle model = EmptyModel(); //   ;   -     
    glm::vec3 position = glm::vec3(0.0f);
    glm::vec3 rotation = glm::vec3(0.0f);
    glm::vec3 scale = glm::vec3(1.0f);
    glm::vec3 mirrorNormal = glm::vec3(0.0f, 1.0f, 0.0f);
+   std::shared_ptr<AssetLoadJob> loading; //  ;   , model 
 
-   SceneObject() : name(""), model(Model("")), position(0.0f), rotation(0.0f), scale(1.0f), mirrorNormal(0.0f, 1.0f, 0.0f) {}
-   SceneObject(const std::string& name, const Model& model) : name(name), model(model) {}
+   SceneObject() : name(""), position(0.0f), rotation(0.0f), scale(1.0f), mirrorNormal(0.0f, 1.0f, 0.0f) {}
+   SceneObject(const std::string& name, ModelHandle model) : name(name), model(std::move(model)) {}
 
+   //   .     position/rotation/scale
+   const glm::mat4& GetModelMatrix() const {
+      UpdateTransformCache();
+      return cachedModelMatrix;
+   }
+
+   //    -      
+   const glm::mat4& GetInverseModelMatrix() const {
+      UpdateTransformCache();
+      return cachedInverseModelMatrix;
+   }
+
+   //     ,     
+   unsigned long long GetTransformVersion() const {
+      UpdateTransformCache();
+      return transformVersion;
+   }
+
+   //    .        
+   const AABB& GetWorldBounds() const {
+      UpdateBoundsCache();
+      return cachedWorldBounds;
+   }
+
+   const BoundingSphere& GetWorldSphere() const {
+      UpdateBoundsCache();
+      return cachedWorldSphere;
+   }
+
+   //      ,   model->meshes.    GetWorldBounds
+   const std::vector<AABB>& GetWorldMeshBounds() const {
+      UpdateBoundsCache();
+      return cachedWorldMeshBounds;
+   }
+
+private:
+   mutable glm::vec3 cachedPosition = glm::vec3(NAN);
+   mutable glm::vec3 cachedRotation = glm::vec3(NAN);
+   mutable glm::vec3 cachedScale = glm::vec3(NAN);
+   mutable glm::mat4 cachedModelMatrix = glm::mat4(1.0f);
+   mutable glm::mat4 cachedInverseModelMatrix = glm::mat4(1.0f);
+   mutable unsigned long long transformVersion = 0;
+   mutable AABB cachedWorldBounds;
+   mutable BoundingSphere cachedWorldSphere;
+   mutable std::vector<AABB> cachedWorldMeshBounds;
+   mutable unsigned long long boundsTransformVersion = 0;
+   mutable const Model* boundsSource = nullptr;
+
+   void UpdateTransformCache() const {
+      if (position == cachedPosition && rotation == cachedRotation && scale == cachedScale)
+         return;
+
+      static unsigned long long versionCounter = 0;
+      cachedPosition = position;
+      cachedRotation = rotation;
+      cachedScale = scale;
+
+      glm::mat4 model = glm::mat4(1.0f);
+      model = glm::translate(model, position);
+      model = glm::rotate(model, glm::radians(rotation.x), glm::vec3(1, 0, 0));
+      model = glm::rotate(model, glm::radians(rotation.y), glm::vec3(0, 1, 0));
+      model = glm::rotate(model, glm::radians(rotation.z), glm::vec3(0, 0, 1));
+      model = glm::scale(model, scale);
+      cachedModelMatrix = model;
+      cachedInverseModelMatrix = glm::inverse(model);
+      transformVersion = ++versionCounter;
+   }
+
+   //  ,    :     
+   void UpdateBoundsCache() const {
+      UpdateTransformCache();
+      if (boundsTransformVersion == transformVersion && boundsSource == model.get())
+         return;
+      boundsTransformVersion = transformVersion;
+      boundsSource = model.get();
+      cachedWorldBounds = model->GetBounds().Transformed(cachedModelMatrix);
+      cachedWorldSphere = model->GetBoundingSphere().Transformed(cachedModelMatrix);
+      cachedWorldMeshBounds.resize(model->meshes.size());
+      for (size_t i = 0; i < model->meshes.size(); ++i)
+         cachedWorldMeshBounds[i] = model->meshes[i].bounds.Transformed(cachedModelMatrix);
+   }
 };
 
+//    BVH  .  ,  
+//          
+inline void UpdateSceneBVH(SceneBVH& sceneBVH, const std::vector<SceneObject>& objects) {
+   //   ,    -    
+   bool unchanged = !sceneBVH.nodes.empty() && sceneBVH.sourceKeys.size() == objects.size();
+   for (size_t i = 0; unchanged && i < objects.size(); ++i)
+      unchanged = sceneBVH.sourceKeys[i] == SceneBVH::SourceKey{ objects[i].model->bvh.get(), objects[i].GetTransformVersion() };
+   if (unchanged)
+      return;
+
+   sceneBVH.Clear();
+   for (int i = 0; i < static_cast<int>(objects.size()); ++i) {
+      const SceneObject& obj = objects[i];
+      sceneBVH.AddInstance(obj.model->bvh, obj.GetModelMatrix(), obj.GetInverseModelMatrix(), i, obj.GetWorldSphere());
+      sceneBVH.sourceKeys.push_back({ obj.model->bvh.get(), obj.GetTransformVersion() });
+   }
+   sceneBVH.Build();
+}
+
 //  
 enum DisplayMode { NORMAL_MODE, FACE_NORMALS, VERTEX_NORMALS };
 enum LightingMode { NONE, NO_LIGHTING, AMBIENT, SPOTLIGHT, DIRECTIONAL, POINT };
@@ -0,0 +1,14 @@
+#version 330 core
+
+in vec3 WorldPos;
+
+uniform vec3 viewPos;
+uniform float objectId; //   + 1, 0   
+
+out vec2 FragData;
+
+void main()
+{
+    //     -   CPU   
+    FragData = vec2(length(WorldPos - viewPos), objectId);
+}
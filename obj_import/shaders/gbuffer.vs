@@ -0,0 +1,17 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 positionScale = vec3(1.0);
+uniform vec3 positionOffset = vec3(0.0);
+
+out vec3 WorldPos;
+
+void main()
+{
+    WorldPos = vec3(model * vec4(aPos * positionScale + positionOffset, 1.0));
+    gl_Position = projection * view * vec4(WorldPos, 1.0);
+}
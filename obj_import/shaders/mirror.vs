@@ -7,14 +7,19 @@ uniform mat4 view;
 uniform mat4 projection;
 uniform mat4 reflectedView;
 uniform mat4 reflectedProj;
+uniform vec3 positionScale = vec3(1.0);
+uniform vec3 positionOffset = vec3(0.0);
 
 out vec4 clipReflectionCoord;
 
 void main()
 {
+    //     (   -  AABB )
+    vec3 position = aPos * positionScale + positionOffset;
+
     //      MVP
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = projection * view * model * vec4(position, 1.0);
 
     //      (  )
-    clipReflectionCoord = reflectedProj * reflectedView * model * vec4(aPos, 1.0);
+    clipReflectionCoord = reflectedProj * reflectedView * model * vec4(position, 1.0);
 }
@@ -0,0 +1,432 @@
+#ifndef SHADOW_TRACER_H
+#define SHADOW_TRACER_H
+
+#include <glad.h>
+
+#include <glm/glm.hpp>
+
+#include "bvh.h"
+#include "gbuffer.h"
+#include "geometry.h"
+#include "job_system.h"
+#include "log.h"
+#include "tile_scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+inline bool TraceShadowRay(const glm::vec3& start, const glm::vec3& end, const SceneBVH& sceneBVH, int ignoreObject) {
+   glm::vec3 direction = glm::normalize(end - start);
+   float lightDistance = glm::length(end - start);
+   Ray ray(start, direction);
+
+   //         -  BVH    
+   if (sceneBVH.Occluded(ray, 0.01f, lightDistance, ignoreObject)) {
+      LOG_EVERY_N(LOG_LEVEL_TRACE, 1000000, "Shadow ray blocked: start [%.3f, %.3f, %.3f], light distance %.3f",
+         start.x, start.y, start.z, lightDistance);
+      return true; //   
+   }
+   return false; //  
+}
+
+//    (    4  )    box.
+//  : false   
+inline bool TileFrustumMissesBox(const glm::vec3& eye, const glm::vec3 corners[4], const AABB& box) {
+   if (!box.Valid()) return true;
+   glm::vec3 center = corners[0] + corners[1] + corners[2] + corners[3];
+   for (int i = 0; i < 4; ++i) {
+      glm::vec3 n = glm::cross(corners[i], corners[(i + 1) % 4]);
+      if (glm::dot(n, center) < 0.0f) n = -n; //   
+      glm::vec3 farthest(n.x > 0.0f ? box.maxBounds.x : box.minBounds.x,
+                         n.y > 0.0f ? box.maxBounds.y : box.minBounds.y,
+                         n.z > 0.0f ? box.maxBounds.z : box.minBounds.z);
+      if (glm::dot(n, farthest - eye) < 0.0f) return true;
+   }
+   return false;
+}
+
+//  ,       .
+//     ,    ,   
+struct ShadowTraceSnapshot {
+   glm::mat4 invProjection = glm::mat4(1.0f);
+   glm::mat4 invView = glm::mat4(1.0f);
+   glm::vec3 cameraPos = glm::vec3(0.0f);
+   glm::vec3 lightPos = glm::vec3(0.0f);
+   SceneBVH scene;
+   //    G- (. GBufferFrame).  ,    
+   std::shared_ptr<const std::vector<glm::vec2>> gBuffer;
+};
+
+//  :      PROGRESSIVE_COARSE_STEP x PROGRESSIVE_COARSE_STEP,
+//          ,    
+//       .  ,   
+// ,    ,       
+const uint32_t PROGRESSIVE_COARSE_STEP = 8; //  ,      
+const int PROGRESSIVE_REFINE_PASSES = 4;    //  8, 4, 2, 1
+const int PROGRESSIVE_ACCUMULATION_PASSES = 8;
+const int PROGRESSIVE_PASS_COUNT = PROGRESSIVE_REFINE_PASSES + PROGRESSIVE_ACCUMULATION_PASSES;
+
+//       (       8x8)
+const glm::vec2 PROGRESSIVE_JITTER[PROGRESSIVE_ACCUMULATION_PASSES] = {
+   { -0.4375f,  0.0625f }, { -0.3125f, -0.3125f }, { -0.1875f,  0.3125f }, { -0.0625f, -0.1875f },
+   {  0.0625f,  0.4375f }, {  0.1875f, -0.4375f }, {  0.3125f,  0.1875f }, {  0.4375f, -0.0625f }
+};
+
+//    . -   :      
+// ( ),      PBO        
+class ShadowTracer {
+public:
+   ShadowTracer(JobSystem& jobs, uint32_t width, uint32_t height, uint32_t tileSize = 16)
+      : jobs(jobs), scheduler(jobs, tileSize), width(width), height(height), mask(width * height, 255) {
+      uint32_t tilesX = (width + tileSize - 1) / tileSize;
+      uint32_t tilesY = (height + tileSize - 1) / tileSize;
+      tileHasShadow.assign(tilesX * tilesY, 1);
+   }
+
+   ~ShadowTracer() {
+      Wait();
+   }
+
+   bool Busy() const { return busy; }
+
+   //    .   ,     ,  
+   //         
+   bool Start(ShadowTraceSnapshot snapshot) {
+      if (busy || ready) return false;
+
+      if (!hasSnapshot || SnapshotChanged(snapshot, current))
+         nextPass = 0;
+      else if (progressive && nextPass >= PassCount(snapshot))
+         return false;
+      current = std::move(snapshot);
+      hasSnapshot = true;
+
+      int pass = progressive ? nextPass++ : -1;
+      lastPass = pass;
+      busy = true;
+      jobs.Submit([this, pass] {
+         if (pass < 0) TraceFull(current);
+         else TraceProgressive(current, pass);
+         std::lock_guard<std::mutex> lock(stateMutex);
+         stats = scheduler.LastStats();
+         ready = true;
+         busy = false;
+         finished.notify_all();
+      });
+      return true;
+   }
+
+   //     -    PBO        GPU  
+   bool UploadIfReady(GLuint texture) {
+      if (!ready) return false;
+
+      if (pbo[0] == 0) glGenBuffers(2, pbo);
+      GLsizeiptr size = static_cast<GLsizeiptr>(mask.size());
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo[pboIndex]);
+      pboIndex ^= 1;
+      glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW); //   
+      void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+      if (dst) {
+         std::memcpy(dst, mask.data(), mask.size());
+         glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+         glBindTexture(GL_TEXTURE_2D, texture);
+         glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+         glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+         glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+      }
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+      ready = false;
+      return true;
+   }
+
+   //    (   )
+   void Wait() {
+      std::unique_lock<std::mutex> lock(stateMutex);
+      finished.wait(lock, [&] { return !busy; });
+   }
+
+   void ReleaseGL() {
+      if (pbo[0] != 0) glDeleteBuffers(2, pbo);
+      pbo[0] = pbo[1] = 0;
+   }
+
+   //     
+   void SetProgressive(bool enabled) {
+      if (enabled == progressive) return;
+      progressive = enabled;
+      nextPass = 0;
+   }
+
+   bool Progressive() const { return progressive; }
+
+   //     (-1 -    )
+   int LastPass() const { return lastPass; }
+   bool Converged() const { return progressive && hasSnapshot && nextPass >= PassCount(current) && !busy; }
+
+   //  ,  ,        :   ( G-  )  
+   bool ConvergedFor(const glm::mat4& invProjection, const glm::mat4& invView, const glm::vec3& cameraPos,
+      const glm::vec3& lightPos, const SceneBVH& scene, bool gBuffer) const {
+      return Converged() && current.invProjection == invProjection && current.invView == invView &&
+         current.cameraPos == cameraPos && current.lightPos == lightPos && current.scene.sourceKeys == scene.sourceKeys &&
+         (current.gBuffer != nullptr) == gBuffer;
+   }
+
+   TileSchedulerStats LastStats() const {
+      std::lock_guard<std::mutex> lock(stateMutex);
+      return stats;
+   }
+
+   int LastHitCount() const { return hitCount; }
+   int LastRayCount() const { return rayCount; }
+
+private:
+   JobSystem& jobs;
+   TileScheduler scheduler;
+   uint32_t width, height;
+   std::vector<unsigned char> mask;
+   std::vector<unsigned char> tileHasShadow;
+   GLuint pbo[2] = { 0, 0 };
+   int pboIndex = 0;
+
+   //  : ,    ,    .
+   //    Start,     
+   ShadowTraceSnapshot current;
+   bool hasSnapshot = false;
+   bool progressive = true;
+   int nextPass = 0;
+   int lastPass = -1;
+   std::vector<unsigned char> edgeMask;  //    ,     
+   std::vector<uint16_t> accumulated;    //     
+
+   std::atomic<bool> busy{ false };
+   std::atomic<bool> ready{ false };
+   std::atomic<int> hitCount{ 0 };
+   std::atomic<int> rayCount{ 0 };
+   mutable std::mutex stateMutex;
+   std::condition_variable finished;
+   TileSchedulerStats stats;
+
+   //  G-    ,    
+   static bool SnapshotChanged(const ShadowTraceSnapshot& a, const ShadowTraceSnapshot& b) {
+      return a.invProjection != b.invProjection || a.invView != b.invView ||
+         a.cameraPos != b.cameraPos || a.lightPos != b.lightPos || !(a.scene.sourceKeys == b.scene.sourceKeys) ||
+         (a.gBuffer != nullptr) != (b.gBuffer != nullptr);
+   }
+
+   //  G-    ,      
+   static int PassCount(const ShadowTraceSnapshot& snap) {
+      return snap.gBuffer ? PROGRESSIVE_REFINE_PASSES : PROGRESSIVE_PASS_COUNT;
+   }
+
+   //      (px, py)  
+   glm::vec3 PrimaryRayDir(const ShadowTraceSnapshot& snap, float px, float py) const {
+      float ndcX = (2.0f * px) / width - 1.0f;
+      float ndcY = 1.0f - (2.0f * py) / height;
+
+      glm::vec4 clipPos = glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+      glm::vec4 viewPos = snap.invProjection * clipPos;
+      viewPos /= viewPos.w; //    
+      glm::vec4 worldPos = snap.invView * viewPos;
+      worldPos /= worldPos.w;
+      return glm::normalize(glm::vec3(worldPos) - snap.cameraPos);
+   }
+
+   //      -      
+   bool TileMissesScene(const ShadowTraceSnapshot& snap, const TileRect& tile, const AABB& sceneBounds) const {
+      glm::vec3 corners[4] = {
+         PrimaryRayDir(snap, float(tile.x0), float(tile.y0)), PrimaryRayDir(snap, float(tile.x1), float(tile.y0)),
+         PrimaryRayDir(snap, float(tile.x1), float(tile.y1)), PrimaryRayDir(snap, float(tile.x0), float(tile.y1))
+      };
+      return TileFrustumMissesBox(snap.cameraPos, corners, sceneBounds);
+   }
+
+   //      (    G-)      .
+   //  true,    
+   bool TracePixel(const ShadowTraceSnapshot& snap, float px, float py, bool& hit) const {
+      glm::vec3 rayOrigin = snap.cameraPos;
+      glm::vec3 rayDir;
+      float minT = std::numeric_limits<float>::max();
+      int hitObject = -1;
+      if (snap.gBuffer) {
+         //    ,   G-   
+         uint32_t x = static_cast<uint32_t>(px), y = static_cast<uint32_t>(py);
+         const glm::vec2& sample = (*snap.gBuffer)[(height - 1 - y) * width + x];
+         rayDir = PrimaryRayDir(snap, x + 0.5f, y + 0.5f);
+         hit = sample.y > 0.0f;
+         if (hit) {
+            minT = sample.x;
+            hitObject = static_cast<int>(sample.y + 0.5f) - 1;
+         }
+      }
+      else {
+         rayDir = PrimaryRayDir(snap, px, py);
+         hit = snap.scene.Intersect(Ray(rayOrigin, rayDir), 0.001f, minT, hitObject);
+      }
+      glm::vec3 hitPoint = hit ? rayOrigin + rayDir * minT : rayOrigin;
+
+      bool inShadow = hit ? TraceShadowRay(hitPoint, snap.lightPos, snap.scene, hitObject) : false;
+
+      //   
+      if (LOG_ENABLED(LOG_LEVEL_DEBUG) && px == float(width / 2) && py == float(height / 2)) {
+         LOG_RATE_LIMITED(LOG_LEVEL_DEBUG, 1000, "Center pixel: ray [%.3f, %.3f, %.3f] -> [%.3f, %.3f, %.3f], hit %d, point [%.3f, %.3f, %.3f], in shadow %d",
+            rayOrigin.x, rayOrigin.y, rayOrigin.z, rayDir.x, rayDir.y, rayDir.z, hit ? 1 : 0,
+            hitPoint.x, hitPoint.y, hitPoint.z, inShadow ? 1 : 0);
+      }
+      return inShadow;
+   }
+
+   void FillBlock(uint32_t x, uint32_t y, uint32_t size, unsigned char value) {
+      uint32_t x1 = std::min(width, x + size);
+      uint32_t y1 = std::min(height, y + size);
+      for (uint32_t row = y; row < y1; ++row)
+         std::fill(&mask[row * width + x], &mask[row * width + x1], value);
+   }
+
+   //   ( )      
+   bool HasDifferentNeighbour(uint32_t x, uint32_t y, uint32_t block, unsigned char value) const {
+      for (int dy = -1; dy <= 1; ++dy) {
+         for (int dx = -1; dx <= 1; ++dx) {
+            int64_t nx = int64_t(x) + dx * int64_t(block);
+            int64_t ny = int64_t(y) + dy * int64_t(block);
+            if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+            if (mask[ny * width + nx] != value) return true;
+         }
+      }
+      return false;
+   }
+
+   //         
+   bool OnShadowEdge(uint32_t x, uint32_t y) const {
+      unsigned char value = edgeMask[y * width + x];
+      return (x > 0 && edgeMask[y * width + x - 1] != value) || (x + 1 < width && edgeMask[y * width + x + 1] != value) ||
+         (y > 0 && edgeMask[(y - 1) * width + x] != value) || (y + 1 < height && edgeMask[(y + 1) * width + x] != value);
+   }
+
+   //  :    
+   void TraceFull(const ShadowTraceSnapshot& snap) {
+      const uint32_t tileSize = scheduler.TileSize();
+      const uint32_t tilesX = (width + tileSize - 1) / tileSize;
+      AABB sceneBounds = snap.scene.Bounds();
+      std::atomic<int> frameHitCount{ 0 };
+
+      scheduler.Run(width, height, [&](const TileRect& tile, unsigned) {
+         uint32_t tileIndex = (tile.y0 / tileSize) * tilesX + tile.x0 / tileSize;
+
+         //   ,           -    
+         if (TileMissesScene(snap, tile, sceneBounds)) {
+            if (tileHasShadow[tileIndex]) {
+               FillBlock(tile.x0, tile.y0, tileSize, 255);
+               tileHasShadow[tileIndex] = 0;
+            }
+            return;
+         }
+
+         int tileHits = 0;
+         bool anyShadow = false;
+         for (uint32_t y = tile.y0; y < tile.y1; ++y) {
+            for (uint32_t x = tile.x0; x < tile.x1; ++x) {
+               bool hit;
+               bool inShadow = TracePixel(snap, float(x), float(y), hit);
+               mask[y * width + x] = inShadow ? 0 : 255;
+               anyShadow = anyShadow || inShadow;
+               if (hit) tileHits++;
+            }
+         }
+         tileHasShadow[tileIndex] = anyShadow ? 1 : 0;
+         frameHitCount += tileHits;
+      });
+
+      hitCount = frameHitCount.load();
+      rayCount = static_cast<int>(width * height);
+   }
+
+   //    
+   void TraceProgressive(const ShadowTraceSnapshot& snap, int pass) {
+      const uint32_t tileSize = scheduler.TileSize();
+      const uint32_t tilesX = (width + tileSize - 1) / tileSize;
+      AABB sceneBounds = snap.scene.Bounds();
+      std::atomic<int> passHitCount{ 0 };
+      std::atomic<int> passRayCount{ 0 };
+
+      scheduler.Run(width, height, [&](const TileRect& tile, unsigned) {
+         uint32_t tileIndex = (tile.y0 / tileSize) * tilesX + tile.x0 / tileSize;
+         if (TileMissesScene(snap, tile, sceneBounds)) {
+            //     ,     
+            if (pass == 0 && tileHasShadow[tileIndex]) {
+               FillBlock(tile.x0, tile.y0, tileSize, 255);
+               tileHasShadow[tileIndex] = 0;
+            }
+            return;
+         }
+         if (pass == 0) tileHasShadow[tileIndex] = 1;
+
+         int tileHits = 0, tileRays = 0;
+         auto trace = [&](float px, float py) {
+            bool hit;
+            bool inShadow = TracePixel(snap, px, py, hit);
+            tileRays++;
+            if (hit) tileHits++;
+            return static_cast<unsigned char>(inShadow ? 0 : 255);
+         };
+
+         if (pass == 0) {
+            //  :    
+            for (uint32_t y = tile.y0; y < tile.y1; y += PROGRESSIVE_COARSE_STEP)
+               for (uint32_t x = tile.x0; x < tile.x1; x += PROGRESSIVE_COARSE_STEP)
+                  FillBlock(x, y, PROGRESSIVE_COARSE_STEP, trace(float(x), float(y)));
+         }
+         else if (pass < PROGRESSIVE_REFINE_PASSES) {
+            // :    ,       .
+            //         ,      
+            uint32_t step = PROGRESSIVE_COARSE_STEP >> pass;
+            uint32_t block = step * 2;
+            for (uint32_t by = tile.y0; by < tile.y1; by += block) {
+               for (uint32_t bx = tile.x0; bx < tile.x1; bx += block) {
+                  if (!HasDifferentNeighbour(bx, by, block, mask[by * width + bx])) continue;
+                  for (uint32_t dy = 0; dy < block; dy += step) {
+                     for (uint32_t dx = 0; dx < block; dx += step) {
+                        uint32_t x = bx + dx, y = by + dy;
+                        if ((dx == 0 && dy == 0) || x >= width || y >= height) continue;
+                        FillBlock(x, y, step, trace(float(x), float(y)));
+                     }
+                  }
+               }
+            }
+         }
+         else {
+            // :       
+            int sample = pass - PROGRESSIVE_REFINE_PASSES;
+            glm::vec2 jitter = PROGRESSIVE_JITTER[sample];
+            for (uint32_t y = tile.y0; y < tile.y1; ++y) {
+               for (uint32_t x = tile.x0; x < tile.x1; ++x) {
+                  if (!OnShadowEdge(x, y)) continue;
+                  uint32_t i = y * width + x;
+                  accumulated[i] += trace(float(x) + jitter.x, float(y) + jitter.y);
+                  mask[i] = static_cast<unsigned char>(accumulated[i] / (sample + 2));
+               }
+            }
+         }
+
+         passHitCount += tileHits;
+         passRayCount += tileRays;
+      });
+
+      //          
+      if (pass == PROGRESSIVE_REFINE_PASSES - 1) {
+         edgeMask = mask;
+         accumulated.assign(mask.begin(), mask.end());
+      }
+
+      hitCount = passHitCount.load();
+      rayCount = passRayCount.load();
+   }
+};
+
+#endif
@@ -0,0 +1,231 @@
+#ifndef TANGENT_SPACE_H
+#define TANGENT_SPACE_H
+
+#include <glm/glm.hpp>
+
+#include "mesh_cache.h"
+#include "job_system.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+//        aiProcess_GenSmoothNormals  aiProcess_CalcTangentSpace.
+//     MeshData,       .
+//   ,      ;  -     .
+//    MikkTSpace:       
+//      ,  ,        UV, 
+
+const uint32_t TANGENT_SPACE_BLOCK = 16384;           //      
+const float TANGENT_SPACE_DEGENERATE_UV = 1e-12f;     //     UV -    
+
+namespace tangent_detail {
+
+   //  fn(begin, end)    [0, count)
+   template <typename Fn>
+   void ForBlocks(size_t count, Fn&& fn) {
+      uint32_t blocks = static_cast<uint32_t>((count + TANGENT_SPACE_BLOCK - 1) / TANGENT_SPACE_BLOCK);
+      GlobalJobSystem().ParallelFor(blocks, [&](uint32_t b, unsigned) {
+         size_t begin = size_t(b) * TANGENT_SPACE_BLOCK;
+         fn(begin, std::min(count, begin + TANGENT_SPACE_BLOCK));
+      });
+   }
+
+   //      (   ):   k  
+   // corners[offsets[k], offsets[k + 1])
+   inline void BuildCornerLists(const std::vector<uint32_t>& cornerKeys, size_t keyCount,
+      std::vector<uint32_t>& offsets, std::vector<uint32_t>& corners) {
+      offsets.assign(keyCount + 1, 0);
+      for (uint32_t key : cornerKeys) offsets[key + 1]++;
+      for (size_t k = 0; k < keyCount; ++k) offsets[k + 1] += offsets[k];
+      corners.resize(cornerKeys.size());
+      std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+      for (size_t c = 0; c < cornerKeys.size(); ++c)
+         corners[fill[cornerKeys[c]]++] = static_cast<uint32_t>(c);
+   }
+
+   //       ( ),    aiProcess_GenSmoothNormals
+   inline size_t GroupPositions(const std::vector<Vertex>& vertices, std::vector<uint32_t>& group) {
+      size_t capacity = 16;
+      while (capacity < vertices.size() * 2) capacity <<= 1;
+      const uint32_t empty = ~0u;
+      std::vector<uint32_t> table(capacity, empty);
+      std::vector<uint32_t> representative;
+      group.resize(vertices.size());
+      for (size_t v = 0; v < vertices.size(); ++v) {
+         uint32_t words[3];
+         memcpy(words, &vertices[v].Position, sizeof(words));
+         uint32_t hash = (words[0] * 73856093u) ^ (words[1] * 19349663u) ^ (words[2] * 83492791u);
+         size_t slot = (hash ^ (hash >> 16)) & (capacity - 1);
+         while (table[slot] != empty && memcmp(&vertices[representative[table[slot]]].Position, words, sizeof(words)) != 0)
+            slot = (slot + 1) & (capacity - 1);
+         if (table[slot] == empty) {
+            table[slot] = static_cast<uint32_t>(representative.size());
+            representative.push_back(static_cast<uint32_t>(v));
+         }
+         group[v] = table[slot];
+      }
+      return representative.size();
+   }
+
+   //   ,  , -    UV-
+   inline glm::vec3 AnyTangent(const glm::vec3& normal) {
+      glm::vec3 axis = std::abs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+      glm::vec3 tangent = axis - normal * glm::dot(normal, axis);
+      float length = glm::length(tangent);
+      return length > 0.0f ? tangent / length : glm::vec3(1.0f, 0.0f, 0.0f);
+   }
+
+   inline glm::vec3 Project(const glm::vec3& v, const glm::vec3& normal) {
+      glm::vec3 projected = v - normal * glm::dot(normal, v);
+      float length = glm::length(projected);
+      return length > 0.0f ? projected / length : glm::vec3(0.0f);
+   }
+
+}
+
+//       (OBJ  vn,   )
+inline bool MeshNeedsNormals(const MeshData& mesh)
+{
+   for (const Vertex& vertex : mesh.vertices)
+      if (vertex.Normal == glm::vec3(0.0f)) return true;
+   return false;
+}
+
+inline bool MeshHasNormalMap(const MeshData& mesh)
+{
+   for (const MeshTextureRef& ref : mesh.textures)
+      if (ref.type == "texture_normal") return true;
+   return false;
+}
+
+//  :          .
+//      :     ( )  
+inline void GenerateSmoothNormals(MeshData& mesh)
+{
+   using namespace tangent_detail;
+   size_t triangleCount = mesh.indices.size() / 3;
+   std::vector<uint32_t> group;
+   size_t groupCount = GroupPositions(mesh.vertices, group);
+
+   std::vector<glm::vec3> faceNormals(triangleCount);
+   ForBlocks(triangleCount, [&](size_t begin, size_t end) {
+      for (size_t t = begin; t < end; ++t) {
+         const glm::vec3& a = mesh.vertices[mesh.indices[t * 3]].Position;
+         faceNormals[t] = glm::cross(mesh.vertices[mesh.indices[t * 3 + 1]].Position - a, mesh.vertices[mesh.indices[t * 3 + 2]].Position - a);
+      }
+   });
+
+   std::vector<uint32_t> cornerKeys(triangleCount * 3);
+   for (size_t c = 0; c < cornerKeys.size(); ++c) cornerKeys[c] = group[mesh.indices[c]];
+   std::vector<uint32_t> offsets, corners;
+   BuildCornerLists(cornerKeys, groupCount, offsets, corners);
+
+   std::vector<glm::vec3> groupNormals(groupCount);
+   ForBlocks(groupCount, [&](size_t begin, size_t end) {
+      for (size_t g = begin; g < end; ++g) {
+         glm::vec3 normal(0.0f);
+         for (uint32_t k = offsets[g]; k < offsets[g + 1]; ++k) normal += faceNormals[corners[k] / 3];
+         groupNormals[g] = glm::dot(normal, normal) > 0.0f ? glm::normalize(normal) : glm::vec3(0.0f, 1.0f, 0.0f);
+      }
+   });
+   ForBlocks(mesh.vertices.size(), [&](size_t begin, size_t end) {
+      for (size_t v = begin; v < end; ++v)
+         if (mesh.vertices[v].Normal == glm::vec3(0.0f)) mesh.vertices[v].Normal = groupNormals[group[v]];
+   });
+}
+
+//      MikkTSpace.     (   -
+//  ),   .       
+inline void GenerateTangents(MeshData& mesh)
+{
+   using namespace tangent_detail;
+   size_t triangleCount = mesh.indices.size() / 3;
+   size_t vertexCount = mesh.vertices.size();
+
+   //    (   )   : +1, -1  0   
+   std::vector<glm::vec3> faceTangents(triangleCount);
+   std::vector<int8_t> orientation(triangleCount);
+   ForBlocks(triangleCount, [&](size_t begin, size_t end) {
+      for (size_t t = begin; t < end; ++t) {
+         const Vertex& a = mesh.vertices[mesh.indices[t * 3]];
+         const Vertex& b = mesh.vertices[mesh.indices[t * 3 + 1]];
+         const Vertex& c = mesh.vertices[mesh.indices[t * 3 + 2]];
+         glm::vec3 d1 = b.Position - a.Position, d2 = c.Position - a.Position;
+         glm::vec2 t1 = b.TexCoords - a.TexCoords, t2 = c.TexCoords - a.TexCoords;
+         float signedArea = t1.x * t2.y - t1.y * t2.x;
+         if (std::abs(signedArea) < TANGENT_SPACE_DEGENERATE_UV) {
+            orientation[t] = 0;
+            continue;
+         }
+         orientation[t] = signedArea > 0.0f ? 1 : -1;
+         faceTangents[t] = (d1 * t2.y - d2 * t1.y) * float(orientation[t]);
+      }
+   });
+
+   std::vector<uint32_t> cornerKeys(mesh.indices.begin(), mesh.indices.end());
+   std::vector<uint32_t> offsets, corners;
+   BuildCornerLists(cornerKeys, vertexCount, offsets, corners);
+
+   //    :       ,  -    .
+   //     
+   std::vector<glm::vec3> positive(vertexCount), negative(vertexCount);
+   std::vector<uint8_t> sides(vertexCount); //  0 -    ,  1 - 
+   ForBlocks(vertexCount, [&](size_t begin, size_t end) {
+      for (size_t v = begin; v < end; ++v) {
+         glm::vec3 normal = mesh.vertices[v].Normal;
+         glm::vec3 sum[2] = { glm::vec3(0.0f), glm::vec3(0.0f) };
+         for (uint32_t k = offsets[v]; k < offsets[v + 1]; ++k) {
+            uint32_t corner = corners[k];
+            size_t t = corner / 3;
+            if (orientation[t] == 0) continue;
+            const glm::vec3& p0 = mesh.vertices[mesh.indices[corner]].Position;
+            glm::vec3 e1 = Project(mesh.vertices[mesh.indices[t * 3 + (corner % 3 + 1) % 3]].Position - p0, normal);
+            glm::vec3 e2 = Project(mesh.vertices[mesh.indices[t * 3 + (corner % 3 + 2) % 3]].Position - p0, normal);
+            float angle = std::acos(glm::clamp(glm::dot(e1, e2), -1.0f, 1.0f));
+            int side = orientation[t] > 0 ? 0 : 1;
+            sum[side] += Project(faceTangents[t], normal) * angle;
+            sides[v] |= uint8_t(1 << side);
+         }
+         positive[v] = sum[0];
+         negative[v] = sum[1];
+      }
+   });
+
+   // :      
+   std::vector<uint32_t> splitIndex(vertexCount, 0);
+   size_t splitCount = 0;
+   for (size_t v = 0; v < vertexCount; ++v)
+      if (sides[v] == 3) splitIndex[v] = static_cast<uint32_t>(vertexCount + splitCount++);
+   if (splitCount > 0) {
+      mesh.vertices.resize(vertexCount + splitCount);
+      for (size_t v = 0; v < vertexCount; ++v)
+         if (sides[v] == 3) mesh.vertices[splitIndex[v]] = mesh.vertices[v];
+      for (size_t c = 0; c < mesh.indices.size(); ++c) {
+         unsigned int v = mesh.indices[c];
+         if (sides[v] == 3 && orientation[c / 3] < 0) mesh.indices[c] = splitIndex[v];
+      }
+   }
+
+   auto finish = [](Vertex& vertex, const glm::vec3& sum, float sign) {
+      float length = glm::length(sum);
+      vertex.Tangent = length > 0.0f ? sum / length : AnyTangent(vertex.Normal);
+      vertex.Bitangent = glm::cross(vertex.Normal, vertex.Tangent) * sign;
+   };
+   ForBlocks(vertexCount, [&](size_t begin, size_t end) {
+      for (size_t v = begin; v < end; ++v) {
+         if (sides[v] == 3) {
+            finish(mesh.vertices[v], positive[v], 1.0f);
+            finish(mesh.vertices[splitIndex[v]], negative[v], -1.0f);
+         }
+         else if (sides[v] == 2)
+            finish(mesh.vertices[v], negative[v], -1.0f);
+         else
+            finish(mesh.vertices[v], positive[v], 1.0f);
+      }
+   });
+}
+
+#endif
@@ -0,0 +1,259 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <glad.h>
+
+#include "stb_image.h"
+#include "job_system.h"
+#include "texture_compression.h"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+//    :   stb_image,     /.
+//    OpenGL      
+struct DecodedImage {
+   std::string path;
+   unsigned char* pixels = nullptr;
+   int width = 0, height = 0, components = 0;
+   CompressedImage compressed;
+
+   void Free() {
+      if (pixels) stbi_image_free(pixels);
+      pixels = nullptr;
+      compressed.Clear();
+   }
+};
+
+//       ;    - stb_image,     
+inline bool DecodeImage(const std::string& filename, DecodedImage& image, TextureUsage usage = TEXTURE_USAGE_COLOR)
+{
+   image.path = filename;
+   TextureCacheKey key;
+   bool compress = GlobalTextureCompression().enabled && MakeTextureCacheKey(filename, usage, key);
+   if (compress && ReadCompressedTexture(key, image.compressed)) {
+      image.width = static_cast<int>(image.compressed.mips[0].width);
+      image.height = static_cast<int>(image.compressed.mips[0].height);
+      return true;
+   }
+
+   //stbi_set_flip_vertically_on_load(true);
+   image.pixels = stbi_load(filename.c_str(), &image.width, &image.height, &image.components, 0);
+   if (image.pixels && compress && CompressImage(image.pixels, image.width, image.height, image.components, usage, image.compressed)) {
+      WriteCompressedTexture(key, image.compressed);
+      stbi_image_free(image.pixels);
+      image.pixels = nullptr;
+   }
+   return image.pixels != nullptr || image.compressed.Valid();
+}
+
+//  GL-   .     ,
+//     glGenerateMipmap.     GL-
+inline unsigned int UploadTexture(const DecodedImage& image)
+{
+   unsigned int textureID;
+   glGenTextures(1, &textureID);
+
+   if (image.compressed.Valid())
+   {
+      glBindTexture(GL_TEXTURE_2D, textureID);
+      const CompressedImage& compressed = image.compressed;
+      for (size_t level = 0; level < compressed.mips.size(); ++level) {
+         const CompressedMip& mip = compressed.mips[level];
+         glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), compressed.format, mip.width, mip.height, 0,
+            static_cast<GLsizei>(mip.size), compressed.data.data() + mip.offset);
+      }
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(compressed.mips.size() - 1));
+
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+   }
+   else if (image.pixels)
+   {
+      GLenum format = GL_RGB;
+      if (image.components == 1)
+         format = GL_RED;
+      else if (image.components == 3)
+         format = GL_RGB;
+      else if (image.components == 4)
+         format = GL_RGBA;
+
+      glBindTexture(GL_TEXTURE_2D, textureID);
+      glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.pixels);
+      glGenerateMipmap(GL_TEXTURE_2D);
+
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+   }
+   else
+   {
+      std::cout << "Texture failed to load at path: " << image.path << std::endl;
+   }
+
+   return textureID;
+}
+
+// GL-   . ,        
+struct CachedTexture {
+   unsigned int id = 0;
+   std::string key;
+   size_t bytes = 0; //      
+};
+
+using TextureHandle = std::shared_ptr<const CachedTexture>;
+
+//         .   TextureHandle,     
+//            GPU  .
+//  ,    ;  glDeleteTextures   CollectGarbage,
+//         
+class TextureCache {
+public:
+   struct Stats {
+      size_t textures = 0;
+      size_t bytes = 0;
+      uint64_t hits = 0;
+      uint64_t misses = 0;
+   };
+
+   //     -   (     ).
+   //   ,    
+   static std::string CanonicalKey(const std::string& path, TextureUsage usage = TEXTURE_USAGE_COLOR) {
+      std::error_code ec;
+      std::filesystem::path canonical = std::filesystem::weakly_canonical(path, ec);
+      if (ec) canonical = std::filesystem::absolute(path, ec).lexically_normal();
+      return canonical.generic_string() + (usage == TEXTURE_USAGE_NORMAL ? "#normal" : "");
+   }
+
+   //     nullptr.     
+   TextureHandle Find(const std::string& key) {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = entries.find(key);
+      return it != entries.end() ? it->second.lock() : nullptr;
+   }
+
+   //   :      .    GL-
+   TextureHandle Acquire(const std::string& path, TextureUsage usage = TEXTURE_USAGE_COLOR) {
+      std::string key = CanonicalKey(path, usage);
+      if (TextureHandle texture = Lookup(key)) return texture;
+
+      DecodedImage image;
+      DecodeImage(path, image, usage);
+      TextureHandle texture = Insert(key, image);
+      image.Free();
+      return texture;
+   }
+
+   //   :     ,    GPU  .
+   //     paths.    GL-
+   std::vector<TextureHandle> AcquireMany(const std::vector<std::string>& paths, const std::vector<TextureUsage>& usages) {
+      std::vector<TextureHandle> result(paths.size());
+      std::vector<std::string> keys(paths.size());
+      std::vector<uint32_t> missing;
+      for (size_t i = 0; i < paths.size(); ++i) {
+         keys[i] = CanonicalKey(paths[i], usages[i]);
+         result[i] = Lookup(keys[i]);
+         if (!result[i]) missing.push_back(static_cast<uint32_t>(i));
+      }
+
+      std::vector<DecodedImage> images(missing.size());
+      GlobalJobSystem().ParallelFor(static_cast<uint32_t>(missing.size()), [&](uint32_t i, unsigned) {
+         DecodeImage(paths[missing[i]], images[i], usages[missing[i]]);
+      });
+      for (size_t i = 0; i < missing.size(); ++i) {
+         //          
+         result[missing[i]] = Find(keys[missing[i]]);
+         if (!result[missing[i]]) result[missing[i]] = Insert(keys[missing[i]], images[i]);
+         images[i].Free();
+      }
+      return result;
+   }
+
+   //     (   ).    GL-
+   TextureHandle Insert(const std::string& key, const DecodedImage& image) {
+      if (TextureHandle existing = Find(key)) return existing;
+
+      CachedTexture* texture = new CachedTexture();
+      texture->id = UploadTexture(image);
+      texture->key = key;
+      texture->bytes = image.compressed.Valid() ? image.compressed.data.size() :
+         static_cast<size_t>(image.width) * image.height * (image.components == 3 ? 4 : std::max(image.components, 1)) * 4 / 3;
+      TextureHandle handle(texture, [this](const CachedTexture* released) { Retire(released); });
+
+      std::lock_guard<std::mutex> lock(mutex);
+      entries[key] = handle;
+      totalBytes += texture->bytes;
+      misses++;
+      return handle;
+   }
+
+   //  GL-,     .        GL-
+   void CollectGarbage() {
+      std::vector<unsigned int> ids;
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         ids.swap(garbage);
+      }
+      if (!ids.empty())
+         glDeleteTextures(static_cast<GLsizei>(ids.size()), ids.data());
+   }
+
+   Stats GetStats() {
+      std::lock_guard<std::mutex> lock(mutex);
+      Stats stats;
+      for (const auto& entry : entries)
+         stats.textures += entry.second.expired() ? 0 : 1;
+      stats.bytes = totalBytes;
+      stats.hits = hits;
+      stats.misses = misses;
+      return stats;
+   }
+
+private:
+   std::mutex mutex;
+   std::unordered_map<std::string, std::weak_ptr<const CachedTexture>> entries;
+   std::vector<unsigned int> garbage;
+   size_t totalBytes = 0;
+   uint64_t hits = 0;
+   uint64_t misses = 0;
+
+   TextureHandle Lookup(const std::string& key) {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = entries.find(key);
+      if (it == entries.end()) return nullptr;
+      TextureHandle texture = it->second.lock();
+      if (texture) hits++;
+      return texture;
+   }
+
+   void Retire(const CachedTexture* texture) {
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         //          
+         auto it = entries.find(texture->key);
+         if (it != entries.end() && it->second.expired()) entries.erase(it);
+         garbage.push_back(texture->id);
+         totalBytes -= texture->bytes;
+      }
+      delete texture;
+   }
+};
+
+//     :  SceneObject        
+inline TextureCache& GlobalTextureCache() {
+   static TextureCache* cache = new TextureCache();
+   return *cache;
+}
+
+#endif
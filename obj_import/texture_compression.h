@@ -0,0 +1,424 @@
+#ifndef TEXTURE_COMPRESSION_H
+#define TEXTURE_COMPRESSION_H
+
+#include <glad.h>
+#include <glm/glm.hpp>
+
+#include "mesh_cache.h"
+#include "job_system.h"
+#include "log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+//    BC1/BC3/BC4/BC5  CPU          DDS.
+//    -  DDS  glCompressedTexImage2D    glGenerateMipmap.
+//  :   - BC5 ( XY, Z    ),  - BC4,
+// RGB   RGBA - BC1, RGBA   - BC3
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+const char* const TEXTURE_CACHE_DIRECTORY = "cache/textures";
+const uint32_t TEXTURE_CACHE_TAG = 0x494A424F;   // "OBJI"  reserved1[0]  DDS
+const uint32_t TEXTURE_CACHE_VERSION = 1;
+
+enum TextureUsage { TEXTURE_USAGE_COLOR, TEXTURE_USAGE_NORMAL };
+
+//  . s3tc      GL, enabled -   UI
+struct TextureCompressionSettings {
+   std::atomic<bool> enabled{ true };
+   std::atomic<bool> s3tc{ false };
+};
+
+inline TextureCompressionSettings& GlobalTextureCompression() {
+   static TextureCompressionSettings settings;
+   return settings;
+}
+
+//   GL.     GL-
+inline bool GLExtensionSupported(const char* name) {
+   GLint count = 0;
+   glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+   for (GLint i = 0; i < count; ++i) {
+      const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+      if (extension && strcmp(extension, name) == 0) return true;
+   }
+   return false;
+}
+
+struct CompressedMip {
+   uint32_t width, height;
+   size_t offset, size;
+};
+
+//         data
+struct CompressedImage {
+   GLenum format = 0;
+   std::vector<uint8_t> data;
+   std::vector<CompressedMip> mips;
+
+   bool Valid() const { return format != 0 && !mips.empty(); }
+   void Clear() {
+      format = 0;
+      data.clear();
+      data.shrink_to_fit();
+      mips.clear();
+   }
+};
+
+namespace bc_detail {
+
+   inline uint16_t Pack565(const glm::vec3& c) {
+      int r = std::clamp(static_cast<int>(c.r * 31.0f / 255.0f + 0.5f), 0, 31);
+      int g = std::clamp(static_cast<int>(c.g * 63.0f / 255.0f + 0.5f), 0, 63);
+      int b = std::clamp(static_cast<int>(c.b * 31.0f / 255.0f + 0.5f), 0, 31);
+      return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+   }
+
+   inline glm::vec3 Unpack565(uint16_t v) {
+      int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+      return glm::vec3((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+   }
+
+   //  4x4 RGBA -> 8  BC1 (    ).
+   //   -        
+   inline void EncodeBC1Block(const uint8_t* rgba, uint8_t* out) {
+      glm::vec3 colors[16];
+      glm::vec3 mean(0.0f);
+      for (int i = 0; i < 16; ++i) {
+         colors[i] = glm::vec3(rgba[i * 4], rgba[i * 4 + 1], rgba[i * 4 + 2]);
+         mean += colors[i];
+      }
+      mean /= 16.0f;
+
+      float cov[6] = { 0, 0, 0, 0, 0, 0 };
+      for (const glm::vec3& c : colors) {
+         glm::vec3 d = c - mean;
+         cov[0] += d.r * d.r; cov[1] += d.r * d.g; cov[2] += d.r * d.b;
+         cov[3] += d.g * d.g; cov[4] += d.g * d.b; cov[5] += d.b * d.b;
+      }
+      //      
+      glm::vec3 axis(1.0f, 1.0f, 1.0f);
+      for (int it = 0; it < 8; ++it) {
+         glm::vec3 next(cov[0] * axis.r + cov[1] * axis.g + cov[2] * axis.b,
+                        cov[1] * axis.r + cov[3] * axis.g + cov[4] * axis.b,
+                        cov[2] * axis.r + cov[4] * axis.g + cov[5] * axis.b);
+         float length = glm::length(next);
+         if (length < 1e-6f) break;
+         axis = next / length;
+      }
+
+      float minProj = 1e30f, maxProj = -1e30f;
+      for (const glm::vec3& c : colors) {
+         float p = glm::dot(c - mean, axis);
+         minProj = std::min(minProj, p);
+         maxProj = std::max(maxProj, p);
+      }
+      //       (  stb_dxt)
+      float inset = (maxProj - minProj) / 16.0f;
+      uint16_t c0 = Pack565(glm::clamp(mean + axis * (maxProj - inset), 0.0f, 255.0f));
+      uint16_t c1 = Pack565(glm::clamp(mean + axis * (minProj + inset), 0.0f, 255.0f));
+      if (c0 < c1) std::swap(c0, c1);
+
+      uint32_t indices = 0;
+      if (c0 != c1) {
+         glm::vec3 palette[4];
+         palette[0] = Unpack565(c0);
+         palette[1] = Unpack565(c1);
+         palette[2] = (palette[0] * 2.0f + palette[1]) / 3.0f;
+         palette[3] = (palette[0] + palette[1] * 2.0f) / 3.0f;
+         for (int i = 0; i < 16; ++i) {
+            int best = 0;
+            float bestDistance = 1e30f;
+            for (int k = 0; k < 4; ++k) {
+               glm::vec3 d = colors[i] - palette[k];
+               float distance = glm::dot(d, d);
+               if (distance < bestDistance) { bestDistance = distance; best = k; }
+            }
+            indices |= static_cast<uint32_t>(best) << (i * 2);
+         }
+      }
+
+      out[0] = c0 & 0xFF; out[1] = c0 >> 8;
+      out[2] = c1 & 0xFF; out[3] = c1 >> 8;
+      for (int i = 0; i < 4; ++i) out[4 + i] = (indices >> (i * 8)) & 0xFF;
+   }
+
+   // 16    -> 8  BC4 (   , a0 > a1)
+   inline void EncodeBC4Block(const uint8_t* values, uint8_t* out) {
+      uint8_t maxValue = 0, minValue = 255;
+      for (int i = 0; i < 16; ++i) {
+         maxValue = std::max(maxValue, values[i]);
+         minValue = std::min(minValue, values[i]);
+      }
+      out[0] = maxValue;
+      out[1] = minValue;
+
+      uint64_t indices = 0;
+      if (maxValue != minValue) {
+         float scale = 7.0f / (maxValue - minValue);
+         for (int i = 0; i < 16; ++i) {
+            //  k  a0  a1: 0 ->  0 (a0), 7 ->  1 (a1), 1..6 ->  2..7
+            int step = static_cast<int>((maxValue - values[i]) * scale + 0.5f);
+            uint64_t index = step == 0 ? 0 : step == 7 ? 1 : static_cast<uint64_t>(step + 1);
+            indices |= index << (i * 3);
+         }
+      }
+      for (int i = 0; i < 6; ++i) out[2 + i] = (indices >> (i * 8)) & 0xFF;
+   }
+
+   //  4x4  RGBA-;     
+   inline void FetchBlock(const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height, uint32_t bx, uint32_t by, uint8_t* block) {
+      for (uint32_t y = 0; y < 4; ++y)
+         for (uint32_t x = 0; x < 4; ++x) {
+            uint32_t sx = std::min(bx * 4 + x, width - 1), sy = std::min(by * 4 + y, height - 1);
+            memcpy(block + (y * 4 + x) * 4, &rgba[(static_cast<size_t>(sy) * width + sx) * 4], 4);
+         }
+   }
+
+   //     2x2
+   inline std::vector<uint8_t> Downsample(const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height, uint32_t& outWidth, uint32_t& outHeight) {
+      outWidth = std::max(1u, width / 2);
+      outHeight = std::max(1u, height / 2);
+      std::vector<uint8_t> result(static_cast<size_t>(outWidth) * outHeight * 4);
+      for (uint32_t y = 0; y < outHeight; ++y)
+         for (uint32_t x = 0; x < outWidth; ++x)
+            for (uint32_t c = 0; c < 4; ++c) {
+               uint32_t x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+               uint32_t y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+               uint32_t sum = rgba[(static_cast<size_t>(y0) * width + x0) * 4 + c] + rgba[(static_cast<size_t>(y0) * width + x1) * 4 + c] +
+                  rgba[(static_cast<size_t>(y1) * width + x0) * 4 + c] + rgba[(static_cast<size_t>(y1) * width + x1) * 4 + c];
+               result[(static_cast<size_t>(y) * outWidth + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+            }
+      return result;
+   }
+
+   inline uint32_t BlockBytes(GLenum format) {
+      return format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RED_RGTC1 ? 8 : 16;
+   }
+
+   inline void EncodeBlock(GLenum format, const uint8_t* block, uint8_t* out) {
+      uint8_t channel[16];
+      switch (format) {
+      case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+         EncodeBC1Block(block, out);
+         break;
+      case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+         for (int i = 0; i < 16; ++i) channel[i] = block[i * 4 + 3];
+         EncodeBC4Block(channel, out);
+         EncodeBC1Block(block, out + 8);
+         break;
+      case GL_COMPRESSED_RED_RGTC1:
+         for (int i = 0; i < 16; ++i) channel[i] = block[i * 4];
+         EncodeBC4Block(channel, out);
+         break;
+      default: // GL_COMPRESSED_RG_RGTC2
+         for (int i = 0; i < 16; ++i) channel[i] = block[i * 4];
+         EncodeBC4Block(channel, out);
+         for (int i = 0; i < 16; ++i) channel[i] = block[i * 4 + 1];
+         EncodeBC4Block(channel, out + 8);
+         break;
+      }
+   }
+
+   //  DDS (   "DDS ")
+   struct DDSHeader {
+      uint32_t size, flags, height, width, linearSize, depth, mipMapCount;
+      uint32_t reserved1[11];
+      uint32_t pfSize, pfFlags, fourCC, rgbBitCount, rMask, gMask, bMask, aMask;
+      uint32_t caps, caps2, caps3, caps4, reserved2;
+   };
+   static_assert(sizeof(DDSHeader) == 124, "DDS header must be 124 bytes");
+
+   inline uint32_t FourCC(GLenum format) {
+      const char* code = format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? "DXT1" : format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT ? "DXT5" :
+         format == GL_COMPRESSED_RED_RGTC1 ? "ATI1" : "ATI2";
+      return static_cast<uint32_t>(code[0]) | (code[1] << 8) | (code[2] << 16) | (static_cast<uint32_t>(code[3]) << 24);
+   }
+
+   inline GLenum FormatFromFourCC(uint32_t fourCC) {
+      const GLenum formats[] = { GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_COMPRESSED_RED_RGTC1, GL_COMPRESSED_RG_RGTC2 };
+      for (GLenum format : formats)
+         if (FourCC(format) == fourCC) return format;
+      return 0;
+   }
+
+   inline bool IsS3TC(GLenum format) {
+      return format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+   }
+}
+
+//   (1-4 ,   stb_image)    .
+// false -     ,     
+inline bool CompressImage(const uint8_t* pixels, int width, int height, int components, TextureUsage usage, CompressedImage& out) {
+   using namespace bc_detail;
+   TextureCompressionSettings& settings = GlobalTextureCompression();
+   if (!settings.enabled || !pixels || width <= 0 || height <= 0 || components < 1 || components > 4) return false;
+
+   //   RGBA8
+   std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+   bool hasAlpha = false;
+   for (size_t i = 0; i < static_cast<size_t>(width) * height; ++i) {
+      const uint8_t* src = pixels + i * components;
+      uint8_t* dst = &rgba[i * 4];
+      if (components <= 2) dst[0] = dst[1] = dst[2] = src[0];
+      else { dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; }
+      dst[3] = components == 2 ? src[1] : components == 4 ? src[3] : 255;
+      hasAlpha = hasAlpha || dst[3] != 255;
+   }
+
+   GLenum format;
+   if (usage == TEXTURE_USAGE_NORMAL) format = GL_COMPRESSED_RG_RGTC2;
+   else if (components == 1) format = GL_COMPRESSED_RED_RGTC1;
+   else format = hasAlpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+   if (IsS3TC(format) && !settings.s3tc) return false;
+
+   out.Clear();
+   out.format = format;
+   uint32_t blockBytes = BlockBytes(format);
+   uint32_t levelWidth = static_cast<uint32_t>(width), levelHeight = static_cast<uint32_t>(height);
+   while (true) {
+      uint32_t blocksX = (levelWidth + 3) / 4, blocksY = (levelHeight + 3) / 4;
+      CompressedMip mip = { levelWidth, levelHeight, out.data.size(), static_cast<size_t>(blocksX) * blocksY * blockBytes };
+      out.data.resize(out.data.size() + mip.size);
+      out.mips.push_back(mip);
+
+      //    
+      uint8_t* levelData = out.data.data() + mip.offset;
+      GlobalJobSystem().ParallelFor(blocksY, [&](uint32_t by, unsigned) {
+         uint8_t block[64];
+         for (uint32_t bx = 0; bx < blocksX; ++bx) {
+            FetchBlock(rgba, levelWidth, levelHeight, bx, by, block);
+            EncodeBlock(format, block, levelData + (static_cast<size_t>(by) * blocksX + bx) * blockBytes);
+         }
+      });
+
+      if (levelWidth == 1 && levelHeight == 1) break;
+      rgba = Downsample(rgba, levelWidth, levelHeight, levelWidth, levelHeight);
+   }
+   return true;
+}
+
+//  :  ,     ,  
+struct TextureCacheKey {
+   std::string sourcePath;
+   uint64_t sourceSize = 0;
+   int64_t sourceTime = 0;
+   TextureUsage usage = TEXTURE_USAGE_COLOR;
+};
+
+inline bool MakeTextureCacheKey(const std::string& path, TextureUsage usage, TextureCacheKey& key) {
+   MeshCacheKey fileKey;
+   if (!MakeMeshCacheKey(path, 0, fileKey)) return false;
+   key.sourcePath = fileKey.sourcePath;
+   key.sourceSize = fileKey.sourceSize;
+   key.sourceTime = fileKey.sourceTime;
+   key.usage = usage;
+   return true;
+}
+
+inline std::string CompressedTextureFilePath(const TextureCacheKey& key) {
+   uint64_t hash = 14695981039346656037ull;
+   for (unsigned char c : key.sourcePath) {
+      hash ^= c;
+      hash *= 1099511628211ull;
+   }
+   hash ^= static_cast<uint64_t>(key.usage);
+   hash *= 1099511628211ull;
+
+   char name[32];
+   snprintf(name, sizeof(name), "%016llx.dds", static_cast<unsigned long long>(hash));
+   return std::string(TEXTURE_CACHE_DIRECTORY) + "/" + name;
+}
+
+//     .      reserved1  DDS
+inline bool ReadCompressedTexture(const TextureCacheKey& key, CompressedImage& image) {
+   using namespace bc_detail;
+   MappedFile file;
+   if (!file.Open(CompressedTextureFilePath(key))) return false;
+   if (file.Size() < 4 + sizeof(DDSHeader) || memcmp(file.Data(), "DDS ", 4) != 0) return false;
+
+   DDSHeader header;
+   memcpy(&header, file.Data() + 4, sizeof(header));
+   uint64_t sourceSize = header.reserved1[2] | (static_cast<uint64_t>(header.reserved1[3]) << 32);
+   int64_t sourceTime = static_cast<int64_t>(header.reserved1[4] | (static_cast<uint64_t>(header.reserved1[5]) << 32));
+   if (header.reserved1[0] != TEXTURE_CACHE_TAG || header.reserved1[1] != TEXTURE_CACHE_VERSION || header.reserved1[6] != static_cast<uint32_t>(key.usage) ||
+      sourceSize != key.sourceSize || sourceTime != key.sourceTime)
+      return false;
+
+   GLenum format = FormatFromFourCC(header.fourCC);
+   if (!format || (IsS3TC(format) && !GlobalTextureCompression().s3tc) || header.width == 0 || header.height == 0 || header.mipMapCount == 0 || header.mipMapCount > 32)
+      return false;
+
+   image.Clear();
+   image.format = format;
+   uint32_t blockBytes = BlockBytes(format);
+   size_t offset = 0, available = file.Size() - 4 - sizeof(DDSHeader);
+   uint32_t width = header.width, height = header.height;
+   for (uint32_t level = 0; level < header.mipMapCount; ++level) {
+      size_t size = static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+      if (size > available - offset) return false;
+      image.mips.push_back({ width, height, offset, size });
+      offset += size;
+      width = std::max(1u, width / 2);
+      height = std::max(1u, height / 2);
+   }
+   const uint8_t* payload = file.Data() + 4 + sizeof(DDSHeader);
+   image.data.assign(payload, payload + offset);
+   return true;
+}
+
+inline bool WriteCompressedTexture(const TextureCacheKey& key, const CompressedImage& image) {
+   using namespace bc_detail;
+   std::error_code ec;
+   std::filesystem::create_directories(TEXTURE_CACHE_DIRECTORY, ec);
+   std::string finalPath = CompressedTextureFilePath(key);
+   std::string tempPath = UniqueTempPath(finalPath);
+
+   DDSHeader header = {};
+   header.size = sizeof(DDSHeader);
+   header.flags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000; // CAPS | HEIGHT | WIDTH | PIXELFORMAT | MIPMAPCOUNT | LINEARSIZE
+   header.width = image.mips[0].width;
+   header.height = image.mips[0].height;
+   header.linearSize = static_cast<uint32_t>(image.mips[0].size);
+   header.mipMapCount = static_cast<uint32_t>(image.mips.size());
+   header.reserved1[0] = TEXTURE_CACHE_TAG;
+   header.reserved1[1] = TEXTURE_CACHE_VERSION;
+   header.reserved1[2] = static_cast<uint32_t>(key.sourceSize);
+   header.reserved1[3] = static_cast<uint32_t>(key.sourceSize >> 32);
+   header.reserved1[4] = static_cast<uint32_t>(static_cast<uint64_t>(key.sourceTime));
+   header.reserved1[5] = static_cast<uint32_t>(static_cast<uint64_t>(key.sourceTime) >> 32);
+   header.reserved1[6] = static_cast<uint32_t>(key.usage);
+   header.pfSize = 32;
+   header.pfFlags = 0x4; // FOURCC
+   header.fourCC = FourCC(image.format);
+   header.caps = 0x1000 | 0x400000 | 0x8; // TEXTURE | MIPMAP | COMPLEX
+
+   {
+      std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+      out.write("DDS ", 4);
+      out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      out.write(reinterpret_cast<const char*>(image.data.data()), image.data.size());
+      if (!out) {
+         LOG_WARN("Texture cache: cannot write %s", tempPath.c_str());
+         out.close();
+         std::filesystem::remove(tempPath, ec);
+         return false;
+      }
+   }
+   return ReplaceCacheFile(tempPath, finalPath);
+}
+
+#endif
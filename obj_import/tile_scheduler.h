@@ -0,0 +1,88 @@
+#ifndef TILE_SCHEDULER_H
+#define TILE_SCHEDULER_H
+
+#include "job_system.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+//    [x0, x1) x [y0, y1)
+struct TileRect {
+   uint32_t x0, y0, x1, y1;
+};
+
+//      ,   
+struct TileTiming {
+   TileRect rect;
+   float milliseconds;
+   unsigned worker;
+};
+
+//    
+struct TileSchedulerStats {
+   unsigned threads = 0;
+   uint32_t tiles = 0;
+   float totalMs = 0.0f;
+   float minTileMs = 0.0f;
+   float avgTileMs = 0.0f;
+   float maxTileMs = 0.0f;
+   std::vector<uint32_t> tilesPerWorker;
+};
+
+//            
+class TileScheduler {
+public:
+   explicit TileScheduler(JobSystem& jobs, uint32_t tileSize = 16) : jobs(jobs), tileSize(tileSize) {}
+
+   void Run(uint32_t width, uint32_t height, const std::function<void(const TileRect& tile, unsigned worker)>& fn) {
+      auto start = std::chrono::high_resolution_clock::now();
+
+      uint32_t tilesX = (width + tileSize - 1) / tileSize;
+      uint32_t tilesY = (height + tileSize - 1) / tileSize;
+      timings.resize(tilesX * tilesY);
+
+      jobs.ParallelFor(tilesX * tilesY, [&](uint32_t index, unsigned worker) {
+         TileRect rect;
+         rect.x0 = (index % tilesX) * tileSize;
+         rect.y0 = (index / tilesX) * tileSize;
+         rect.x1 = std::min(width, rect.x0 + tileSize);
+         rect.y1 = std::min(height, rect.y0 + tileSize);
+
+         auto tileStart = std::chrono::high_resolution_clock::now();
+         fn(rect, worker);
+         float ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - tileStart).count();
+         timings[index] = { rect, ms, worker };
+      });
+
+      //   
+      stats.threads = jobs.ThreadCount();
+      stats.tiles = static_cast<uint32_t>(timings.size());
+      stats.totalMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+      stats.tilesPerWorker.assign(stats.threads, 0);
+      stats.minTileMs = timings.empty() ? 0.0f : timings[0].milliseconds;
+      stats.maxTileMs = 0.0f;
+      float sum = 0.0f;
+      for (const TileTiming& t : timings) {
+         stats.minTileMs = std::min(stats.minTileMs, t.milliseconds);
+         stats.maxTileMs = std::max(stats.maxTileMs, t.milliseconds);
+         sum += t.milliseconds;
+         if (t.worker < stats.tilesPerWorker.size()) stats.tilesPerWorker[t.worker]++;
+      }
+      stats.avgTileMs = timings.empty() ? 0.0f : sum / timings.size();
+   }
+
+   const std::vector<TileTiming>& LastTimings() const { return timings; }
+   const TileSchedulerStats& LastStats() const { return stats; }
+   uint32_t TileSize() const { return tileSize; }
+
+private:
+   JobSystem& jobs;
+   uint32_t tileSize;
+   std::vector<TileTiming> timings;
+   TileSchedulerStats stats;
+};
+
+#endif